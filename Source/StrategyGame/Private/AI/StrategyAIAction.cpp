@@ -7,36 +7,36 @@
 
 UStrategyAIAction::UStrategyAIAction(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
-	, bIsExecuted(false)
+	, FactDependencies(EStrategyAIFact::All)
 {
 }
 
-bool UStrategyAIAction::Tick(float DeltaTime) 
+bool UStrategyAIAction::Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const
 { 
 	return false; 
 }
 
-bool UStrategyAIAction::ShouldActivate() const 
+bool UStrategyAIAction::ShouldActivate(AStrategyAIController* Controller) const
 { 
 	return false; 
 }
 
-void UStrategyAIAction::Abort() 
+void UStrategyAIAction::Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	bIsExecuted = false; 
+	State.bIsExecuted = false; 
 }
 
-bool UStrategyAIAction::IsSafeToAbort() const 
+bool UStrategyAIAction::IsSafeToAbort(const FStrategyAIActionState& State) const
 { 
 	return true; 
 }
 
-void UStrategyAIAction::Activate()
+void UStrategyAIAction::Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 { 		
-	bIsExecuted = true; 
+	State.bIsExecuted = true; 
 }
 
-void UStrategyAIAction::SetController(AStrategyAIController* InOwner)
-{ 
-	MyAIController = InOwner; 
+uint8 UStrategyAIAction::GetFactDependencies() const
+{
+	return FactDependencies;
 }
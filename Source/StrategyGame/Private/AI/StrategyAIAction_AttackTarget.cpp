@@ -7,167 +7,187 @@
 
 UStrategyAIAction_AttackTarget::UStrategyAIAction_AttackTarget(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
-, MeleeAttackAnimationEndTime(0)
-, bIsPlayingAnimation(false)
-, bMovingToTarget(false)
 {
 	// Non-property initialization
+	FactDependencies = EStrategyAIFact::CurrentTarget;
 }
 
 /** function to register as Update delegate for this action */
-bool UStrategyAIAction_AttackTarget::Tick(float DeltaTime)
+bool UStrategyAIAction_AttackTarget::Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const
 {
-	check(MyAIController.IsValid());
-	Super::Tick(DeltaTime);
+	check(Controller);
+	Super::Tick(Controller, State, DeltaTime);
 
-	UpdateTargetInformation();
+	UpdateTargetInformation(Controller, State);
 
-	bIsPlayingAnimation = MyAIController->GetWorld()->GetTimeSeconds() < MeleeAttackAnimationEndTime;
-	if (!bIsPlayingAnimation)
+	State.bIsPlayingAnimation = Controller->GetWorld()->GetTimeSeconds() < State.MeleeAttackAnimationEndTime;
+	if (!State.bIsPlayingAnimation)
 	{
-		if (!TargetActor.IsValid())
+		if (!State.TargetActor.IsValid())
 		{
 			return false;
 		}
 
-		// try move closer if needed again
-		MoveCloser();
+		// try move closer if needed again, give up when there is no way to the target
+		if (!MoveCloser(Controller, State))
+		{
+			return false;
+		}
 
-		if (!bMovingToTarget)
+		if (!State.bIsMoving)
 		{
-			AStrategyChar* const MyChar = Cast<AStrategyChar>(MyAIController->GetPawn());
+			AStrategyChar* const MyChar = Cast<AStrategyChar>(Controller->GetPawn());
 			if (MyChar != NULL)
 			{
 				//播放战斗动画，并记录下结束时间
-				MeleeAttackAnimationEndTime = MyAIController->GetWorld()->GetTimeSeconds() + MyChar->PlayMeleeAnim();
-				bIsPlayingAnimation = true;
+				State.MeleeAttackAnimationEndTime = Controller->GetWorld()->GetTimeSeconds() + MyChar->PlayMeleeAnim();
+				State.bIsPlayingAnimation = true;
 			}
 		}
 
-		return MyAIController->IsTargetValid(TargetActor.Get());
+		return Controller->IsTargetValid(State.TargetActor.Get());
 	}
 
 	return true;
 }
 
-void UStrategyAIAction_AttackTarget::UpdateTargetInformation()
+void UStrategyAIAction_AttackTarget::UpdateTargetInformation(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	AActor* const OldTargetActor = TargetActor.Get();
-	if (MyAIController->CurrentTarget != TargetActor.Get())
+	AActor* const OldTargetActor = State.TargetActor.Get();
+	if (Controller->CurrentTarget != State.TargetActor.Get())
 	{
-		TargetActor = MyAIController->CurrentTarget;
+		State.TargetActor = Controller->CurrentTarget;
 	}
 
-	if (OldTargetActor != TargetActor.Get() && bMovingToTarget)
+	if (OldTargetActor != State.TargetActor.Get() && State.bIsMoving)
 	{
-		bMovingToTarget = false;
+		State.bIsMoving = false;
 	}
 
-	if (MyAIController->IsTargetValid(TargetActor.Get()) )
+	if (Controller->IsTargetValid(State.TargetActor.Get()) )
 	{
-		MyAIController->SetFocus(TargetActor.Get());
+		Controller->SetFocus(State.TargetActor.Get());
 	}
 }
 
-void UStrategyAIAction_AttackTarget::MoveCloser()
+bool UStrategyAIAction_AttackTarget::MoveCloser(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
+	check(Controller);
 
-	if (bIsPlayingAnimation || bMovingToTarget || TargetActor == nullptr)
+	if (State.bIsPlayingAnimation || State.bIsMoving || !State.TargetActor.IsValid())
 	{
-		return;
+		return true;
 	}
 		
-	TargetDestination = TargetActor->GetActorLocation();
-	AStrategyChar* const MyChar = Cast<AStrategyChar>(MyAIController->GetPawn());
+	State.Destination = State.TargetActor->GetActorLocation();
+	AStrategyChar* const MyChar = Cast<AStrategyChar>(Controller->GetPawn());
 	if( MyChar == nullptr )
 	{
 		UE_LOG(LogStrategyAI, Warning, TEXT("Invalid Char/Pawn in Move Closer")); 
-		return;
+		return false;
 	}
 	
 	check(MyChar->GetPawnData());
 
 	//检查是否在攻击范围内
 	const float AttackDistance = MyChar->GetPawnData()->AttackDistance;
-	const float Dist = (TargetDestination - MyAIController->GetAdjustLocation()).Size2D();
+	const float Dist = (State.Destination - Controller->GetAdjustLocation()).Size2D();
 
 	if (Dist > AttackDistance)
 	{
 		//不在攻击范围内，则寻路到目标
-		UE_VLOG(MyAIController.Get(), LogStrategyAI, Log, TEXT("Let's move closer")); 
-		bMovingToTarget = true;
-		MyAIController->MoveToActor(TargetActor.Get(), 0.9 * AttackDistance);
+		UE_VLOG(Controller, LogStrategyAI, Log, TEXT("Let's move closer")); 
+		State.bIsMoving = true;
+		Controller->MoveToActorAsync(State.TargetActor.Get(), 0.9 * AttackDistance);
+
+		//没有导航数据或者命中了失败的缓存路径时，OnMoveCompleted会在调用中立即执行
+		if (!State.bIsMoving)
+		{
+			UE_VLOG(Controller, LogStrategyAI, Log, TEXT("Can't move closer"));
+			return false;
+		}
 	}
+
+	return true;
 }
 
-void UStrategyAIAction_AttackTarget::OnMoveCompleted()
+void UStrategyAIAction_AttackTarget::OnMoveCompleted(AStrategyAIController* Controller) const
 {
-	bMovingToTarget = false;
-	if (MyAIController->GetPathFollowingComponent())
+	FStrategyAIActionState* const State = Controller->GetActionState(this);
+	if (State != NULL)
+	{
+		State->bIsMoving = false;
+	}
+
+	Controller->AbortPendingMove();
+	if (Controller->GetPathFollowingComponent())
 	{
-		MyAIController->GetPathFollowingComponent()->AbortMove(TEXT("close enought"));
+		Controller->GetPathFollowingComponent()->AbortMove(TEXT("close enought"));
 	}
 }
 
-void UStrategyAIAction_AttackTarget::NotifyBump(FHitResult const& Hit)
+void UStrategyAIAction_AttackTarget::NotifyBump(FHitResult const& Hit, AStrategyAIController* Controller) const
 {
-	check(MyAIController.IsValid());
+	check(Controller);
+
+	FStrategyAIActionState* const State = Controller->GetActionState(this);
 
 	//如果撞上了敌人，则结束寻路
 	// if we hit our target, just stop movement
 	AStrategyChar* const HitChar = Cast<AStrategyChar>(Hit.Actor.Get());
-	if (HitChar != NULL && AStrategyGameMode::OnEnemyTeam(HitChar, MyAIController->GetPawn()) && bMovingToTarget)
+	if (HitChar != NULL && State != NULL && AStrategyGameMode::OnEnemyTeam(HitChar, Controller->GetPawn()) && State->bIsMoving)
 	{
-		bMovingToTarget = false;
-		if (MyAIController->GetPathFollowingComponent())
+		State->bIsMoving = false;
+		Controller->AbortPendingMove();
+		if (Controller->GetPathFollowingComponent())
 		{
-			MyAIController->GetPathFollowingComponent()->AbortMove(TEXT("Bump"));
+			Controller->GetPathFollowingComponent()->AbortMove(TEXT("Bump"));
 		}
 	}
 }
 
-void UStrategyAIAction_AttackTarget::Activate()
+void UStrategyAIAction_AttackTarget::Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Activate();
+	check(Controller);
+	Super::Activate(Controller, State);
 
-	bIsPlayingAnimation = false;
-	MeleeAttackAnimationEndTime = 0;
-	TargetActor = MyAIController->CurrentTarget;
+	State.bIsPlayingAnimation = false;
+	State.MeleeAttackAnimationEndTime = 0;
+	State.TargetActor = Controller->CurrentTarget;
 
 	FOnBumpEvent BumpDelegate;
-	BumpDelegate.BindUObject(this, &UStrategyAIAction_AttackTarget::NotifyBump);
-	MyAIController->RegisterBumpEventDelegate(BumpDelegate);
+	BumpDelegate.BindUObject(this, &UStrategyAIAction_AttackTarget::NotifyBump, Controller);
+	Controller->RegisterBumpEventDelegate(BumpDelegate);
 
 	FOnMovementEvent MovementDelegate;
-	MovementDelegate.BindUObject(this, &UStrategyAIAction_AttackTarget::OnMoveCompleted);
-	MyAIController->RegisterMovementEventDelegate(MovementDelegate);
+	MovementDelegate.BindUObject(this, &UStrategyAIAction_AttackTarget::OnMoveCompleted, Controller);
+	Controller->RegisterMovementEventDelegate(MovementDelegate);
 }
 
 
-bool UStrategyAIAction_AttackTarget::IsSafeToAbort() const
+bool UStrategyAIAction_AttackTarget::IsSafeToAbort(const FStrategyAIActionState& State) const
 {
-	return !bIsPlayingAnimation;
+	return !State.bIsPlayingAnimation;
 }
 
-void UStrategyAIAction_AttackTarget::Abort()
+void UStrategyAIAction_AttackTarget::Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Abort();
+	check(Controller);
+	Super::Abort(Controller, State);
 
-	if (bMovingToTarget && MyAIController->GetPathFollowingComponent())
+	Controller->AbortPendingMove();
+	if (State.bIsMoving && Controller->GetPathFollowingComponent())
 	{
-		MyAIController->GetPathFollowingComponent()->AbortMove(TEXT("abort attack"));
+		Controller->GetPathFollowingComponent()->AbortMove(TEXT("abort attack"));
 	}
-	bMovingToTarget = false;
-	MyAIController->ClearFocus(EAIFocusPriority::Gameplay);
-	MyAIController->UnregisterBumpEventDelegate();
-	MyAIController->UnregisterMovementEventDelegate();
+	State.bIsMoving = false;
+	Controller->ClearFocus(EAIFocusPriority::Gameplay);
+	Controller->UnregisterBumpEventDelegate();
+	Controller->UnregisterMovementEventDelegate();
 }
 
-bool UStrategyAIAction_AttackTarget::ShouldActivate() const
+bool UStrategyAIAction_AttackTarget::ShouldActivate(AStrategyAIController* Controller) const
 {
-	check(MyAIController.IsValid());
-	return MyAIController->CurrentTarget != NULL && MyAIController->IsTargetValid(MyAIController->CurrentTarget);
+	check(Controller);
+	return Controller->CurrentTarget != NULL && Controller->IsTargetValid(Controller->CurrentTarget);
 }
@@ -6,124 +6,251 @@
 #include "StrategyBuilding_Brewery.h"
 #include "StrategyAIDirector.h"
 #include "AI/Navigation/NavigationPathGenerator.h"
+#include "AI/Navigation/NavigationSystem.h"
 
 #include "VisualLogger/VisualLogger.h"
 
 UStrategyAIAction_MoveToBrewery::UStrategyAIAction_MoveToBrewery(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	, TargetAcceptanceRadius(150)
-	, Destination(FVector::ZeroVector)
-	, bIsMoving(false)
-	, NotMovingFromTime(0)
+	, FlowFieldWaypointSteps(8)
+	, FormationRepathDistance(100)
+	, MaxFormationDistance(800)
 {
+	FactDependencies = EStrategyAIFact::Brewery | EStrategyAIFact::Arrived;
 }
 
-bool UStrategyAIAction_MoveToBrewery::IsSafeToAbort() const
+bool UStrategyAIAction_MoveToBrewery::IsSafeToAbort(const FStrategyAIActionState& State) const
 {
 	return true; //移动可以随时被打断
 }
 
-void UStrategyAIAction_MoveToBrewery::Abort()
+void UStrategyAIAction_MoveToBrewery::Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Abort();
+	check(Controller);
+	Super::Abort(Controller, State);
 
-	bIsMoving = false;
-	Destination = FVector::ZeroVector;
+	State.bIsMoving = false;
+	State.bFollowingFlowField = false;
+	State.bFollowingLeader = false;
+	State.Destination = FVector::ZeroVector;
 	//打断寻路
-	if (MyAIController->GetPathFollowingComponent())
+	Controller->AbortPendingMove();
+	if (Controller->GetPathFollowingComponent())
 	{
-		MyAIController->GetPathFollowingComponent()->AbortMove(TEXT("abort brewery"));
+		Controller->GetPathFollowingComponent()->AbortMove(TEXT("abort brewery"));
 	}
 	//取消结束事件监听
-	MyAIController->UnregisterMovementEventDelegate();
+	Controller->UnregisterMovementEventDelegate();
 }
 
-void UStrategyAIAction_MoveToBrewery::Activate()
+void UStrategyAIAction_MoveToBrewery::Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const
 {
-	check(MyAIController.IsValid());
-	Super::Activate();
+	check(Controller);
+	Super::Activate(Controller, State);
 
-	NotMovingFromTime = 0;
-	// find brewery base and cache it's destination
-	const FPlayerData* TeamData = MyAIController->GetTeamData();
-	if (TeamData != NULL && TeamData->Brewery != NULL && TeamData->Brewery->GetAIDirector() != NULL)
+	State.NotMovingFromTime = 0;
+	//获取目标酒厂的位置
+	AActor* const Actor = GetEnemyBrewery(Controller);
+	if (Actor != NULL)
 	{
-		//获取目标酒厂的位置
-		const AActor* Actor = TeamData->Brewery->GetAIDirector()->GetEnemyBrewery();
-		if (Actor != NULL)
+		State.bIsMoving = true;
+		State.Destination = Actor->GetActorLocation();
+		State.Waypoint = FVector::ZeroVector;
+		//队员跟着队长走，只有队长需要寻路
+		State.bFollowingLeader = FollowLeader(Controller, State);
+		if (!State.bFollowingLeader)
 		{
-			bIsMoving = true;
-			Destination = Actor->GetActorLocation();
-			//寻路到目标点
-			MyAIController->MoveToLocation(Destination, TargetAcceptanceRadius, true, true, true);
+			MoveOnOwn(Controller, State, Actor);
 		}
 	}
 
 	//监听 移动结束事件
 	FOnMovementEvent MovementDelegate;
-	MovementDelegate.BindUObject(this, &UStrategyAIAction_MoveToBrewery::OnMoveCompleted);
-	MyAIController->RegisterMovementEventDelegate(MovementDelegate);
+	MovementDelegate.BindUObject(this, &UStrategyAIAction_MoveToBrewery::OnMoveCompleted, Controller);
+	Controller->RegisterMovementEventDelegate(MovementDelegate);
 }
 
-bool UStrategyAIAction_MoveToBrewery::Tick(float DeltaTime)
+bool UStrategyAIAction_MoveToBrewery::Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const
 {
-	if (bIsMoving && MyAIController.IsValid())
+	if (State.bIsMoving && Controller != NULL)
 	{
-		const bool bNoMove = (MyAIController->GetMoveStatus() != EPathFollowingStatus::Moving);
+		const bool bNoMove = (Controller->GetMoveStatus() != EPathFollowingStatus::Moving);
 		if (!bNoMove)
 		{
-			NotMovingFromTime = 0;
+			State.NotMovingFromTime = 0;
 		}
-		else if (NotMovingFromTime == 0)
+		else if (State.NotMovingFromTime == 0)
 		{
-			NotMovingFromTime = MyAIController->GetWorld()->TimeSeconds;
+			State.NotMovingFromTime = Controller->GetWorld()->TimeSeconds;
 		}
 
 		//如果停止移动超过2秒后，结束当前Action
-		if (bNoMove && (MyAIController->GetWorld()->TimeSeconds - NotMovingFromTime) > 2)
+		if (bNoMove && (Controller->GetWorld()->TimeSeconds - State.NotMovingFromTime) > 2)
+		{
+			Abort(Controller, State);
+		}
+		else if (State.bFollowingLeader && !FollowLeader(Controller, State))
 		{
-			Abort();
+			// leader is gone or we fell behind, from now on we find our own way
+			State.bFollowingLeader = false;
+			AActor* const Brewery = GetEnemyBrewery(Controller);
+			if (Brewery != NULL)
+			{
+				MoveOnOwn(Controller, State, Brewery);
+			}
 		}
 	}
-	return bIsExecuted && Destination != FVector::ZeroVector && bIsMoving;
+	return State.bIsExecuted && State.Destination != FVector::ZeroVector && State.bIsMoving;
 }
 
-bool UStrategyAIAction_MoveToBrewery::ShouldActivate() const
+bool UStrategyAIAction_MoveToBrewery::ShouldActivate(AStrategyAIController* Controller) const
 {
-	check(MyAIController.IsValid());
+	check(Controller);
 
 	FVector DesiredDestination = FVector::ZeroVector;
-	const FPlayerData* TeamData = MyAIController->GetTeamData();
-	if (TeamData != NULL && TeamData->Brewery != NULL && TeamData->Brewery->GetAIDirector() != NULL)
+	const AActor* Actor = GetEnemyBrewery(Controller);
+	if (Actor != NULL)
 	{
-		const AActor* Actor = TeamData->Brewery->GetAIDirector()->GetEnemyBrewery();
-		if (Actor != NULL)
-		{
-			DesiredDestination = Actor->GetActorLocation();
-		}
+		DesiredDestination = Actor->GetActorLocation();
 	}
 
 	if (DesiredDestination != FVector::ZeroVector)
 	{
 		//如果距离太近，就无需移动了
-		return ((DesiredDestination - MyAIController->GetAdjustLocation()).Size2D() > TargetAcceptanceRadius);
+		return ((DesiredDestination - Controller->GetAdjustLocation()).Size2D() > TargetAcceptanceRadius);
 	}
 	return false;
 }
 
-void UStrategyAIAction_MoveToBrewery::OnMoveCompleted()
+AActor* UStrategyAIAction_MoveToBrewery::GetEnemyBrewery(AStrategyAIController* Controller) const
 {
-	bIsMoving = false;
+	const FPlayerData* TeamData = Controller->GetTeamData();
+	if (TeamData != NULL && TeamData->Brewery != NULL && TeamData->Brewery->GetAIDirector() != NULL)
+	{
+		return TeamData->Brewery->GetAIDirector()->GetEnemyBrewery();
+	}
+	return NULL;
 }
 
-void UStrategyAIAction_MoveToBrewery::OnPathUpdated(INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType)
+void UStrategyAIAction_MoveToBrewery::MoveOnOwn(AStrategyAIController* Controller, FStrategyAIActionState& State, AActor* Brewery) const
 {
-	check(MyAIController.IsValid());
+	//沿着流场移动，没有流场时才寻路到目标点
+	State.bFollowingFlowField = FollowFlowField(Controller, State, Brewery);
+	if (!State.bFollowingFlowField)
+	{
+		Controller->MoveToLocationAsync(State.Destination, TargetAcceptanceRadius);
+	}
+}
+
+bool UStrategyAIAction_MoveToBrewery::FollowLeader(AStrategyAIController* Controller, FStrategyAIActionState& State) const
+{
+	const FStrategySquad* const Squad = Controller->GetSquad();
+	FVector SlotLocation;
+	if (Squad == NULL || !Squad->GetFormationLocation(Controller, SlotLocation))
+	{
+		return false;
+	}
+
+	// too far to walk straight, there may be walls in between
+	const FVector PawnLocation = Controller->GetAdjustLocation();
+	if (FVector::DistSquared2D(PawnLocation, SlotLocation) > FMath::Square(MaxFormationDistance))
+	{
+		return false;
+	}
+
+	//阵位移动得足够远，或者停下后离阵位太远时才更新移动目标
+	const float RepathDistSq = FMath::Square(FormationRepathDistance);
+	const bool bSlotMoved = FVector::DistSquared2D(SlotLocation, State.Waypoint) > RepathDistSq;
+	const bool bOutOfSlot = Controller->GetMoveStatus() != EPathFollowingStatus::Moving && FVector::DistSquared2D(PawnLocation, SlotLocation) > RepathDistSq;
+	if (bSlotMoved || bOutOfSlot)
+	{
+		State.Waypoint = SlotLocation;
+		Controller->AbortPendingMove();
+		Controller->MoveToLocation(SlotLocation, -1.0f, false, false, false);
+	}
+	return true;
+}
+
+bool UStrategyAIAction_MoveToBrewery::FollowFlowField(AStrategyAIController* Controller, FStrategyAIActionState& State, AActor* Brewery) const
+{
+	AStrategyGameState* const GameState = Controller->GetWorld()->GetGameState<AStrategyGameState>();
+	const FStrategyFlowField* const FlowField = GameState != NULL ? GameState->GetFlowField(Brewery) : NULL;
+	if (FlowField == NULL)
+	{
+		return false;
+	}
+
+	// continue from last waypoint when we got close to it, so we always make progress along the field
+	const FVector PawnLocation = Controller->GetAdjustLocation();
+	const bool bNearWaypoint = State.Waypoint != FVector::ZeroVector && FVector::DistSquared2D(PawnLocation, State.Waypoint) < FMath::Square(FlowField->GetCellSize());
+	const FVector FromLocation = bNearWaypoint ? State.Waypoint : PawnLocation;
+
+	FVector NextWaypoint;
+	if (!FlowField->GetWaypoint(FromLocation, FlowFieldWaypointSteps, NextWaypoint))
+	{
+		return false;
+	}
+
+	//单位不一定站在格子中心，直线走不到路点时改用寻路
+	FVector HitLocation;
+	if (UNavigationSystem::NavigationRaycast(Controller->GetWorld(), PawnLocation, NextWaypoint, HitLocation))
+	{
+		return false;
+	}
+
+	// straight move, the field already knows the way
+	State.Waypoint = NextWaypoint;
+	Controller->AbortPendingMove();
+	Controller->MoveToLocation(NextWaypoint, -1.0f, false, false, false);
+	return true;
+}
+
+void UStrategyAIAction_MoveToBrewery::OnMoveCompleted(AStrategyAIController* Controller) const
+{
+	FStrategyAIActionState* const State = Controller->GetActionState(this);
+	if (State == NULL)
+	{
+		return;
+	}
+
+	// reached formation slot, next tick moves us to where it is now
+	if (State->bFollowingLeader && State->bIsMoving)
+	{
+		return;
+	}
+
+	if (State->bFollowingFlowField && State->bIsMoving)
+	{
+		//到达一个路点后继续沿着流场前进，到达流场终点后再寻路到酒厂
+		AActor* const Brewery = GetEnemyBrewery(Controller);
+		if (Brewery != NULL && FollowFlowField(Controller, *State, Brewery))
+		{
+			return;
+		}
+
+		State->bFollowingFlowField = false;
+		if (Brewery != NULL)
+		{
+			Controller->MoveToLocationAsync(State->Destination, TargetAcceptanceRadius);
+			return;
+		}
+	}
+
+	State->bIsMoving = false;
+}
+
+void UStrategyAIAction_MoveToBrewery::OnPathUpdated(INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType, AStrategyAIController* Controller) const
+{
+	check(Controller);
 
 	if (inType != EPathUpdate::Update)
 	{
-		UE_VLOG(MyAIController.Get(), LogStrategyAI, Log, TEXT("WARRNING, OnPathUpdated with error - PathUpdateTyp %d"), int32(inType)); 
-		Abort();
+		UE_VLOG(Controller, LogStrategyAI, Log, TEXT("WARRNING, OnPathUpdated with error - PathUpdateTyp %d"), int32(inType)); 
+		FStrategyAIActionState* const State = Controller->GetActionState(this);
+		if (State != NULL)
+		{
+			Abort(Controller, *State);
+		}
 	}
 }
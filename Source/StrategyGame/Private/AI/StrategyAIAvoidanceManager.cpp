@@ -0,0 +1,370 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAIAvoidanceManager.h"
+#include "StrategyMinionMovementComponent.h"
+#include "ParallelFor.h"
+
+namespace StrategyAvoidance
+{
+	/** half-plane of permitted velocities, to the left of the line */
+	struct FLine
+	{
+		FVector2D Point;
+		FVector2D Direction;
+	};
+
+	typedef TArray<FLine, TInlineAllocator<16> > FLineArray;
+
+	static const float Epsilon = 0.00001f;
+
+	/** determinant of 2x2 matrix made of two vectors */
+	FORCEINLINE float Det(const FVector2D& A, const FVector2D& B)
+	{
+		return A.X * B.Y - A.Y * B.X;
+	}
+
+	/** find velocity on line LineNo closest to preferred one, satisfying all previous lines and speed limit */
+	static bool SolveOnLine(const FLineArray& Lines, int32 LineNo, float Radius, const FVector2D& OptVelocity, bool bDirectionOpt, FVector2D& Result)
+	{
+		const FLine& Line = Lines[LineNo];
+		const float DotProduct = Line.Point | Line.Direction;
+		const float Discriminant = FMath::Square(DotProduct) + FMath::Square(Radius) - Line.Point.SizeSquared();
+		if (Discriminant < 0.0f)
+		{
+			// speed limit invalidates whole line
+			return false;
+		}
+
+		const float SqrtDiscriminant = FMath::Sqrt(Discriminant);
+		float TLeft = -DotProduct - SqrtDiscriminant;
+		float TRight = -DotProduct + SqrtDiscriminant;
+
+		for (int32 Idx = 0; Idx < LineNo; Idx++)
+		{
+			const float Denominator = Det(Line.Direction, Lines[Idx].Direction);
+			const float Numerator = Det(Lines[Idx].Direction, Line.Point - Lines[Idx].Point);
+			if (FMath::Abs(Denominator) <= Epsilon)
+			{
+				// parallel lines
+				if (Numerator < 0.0f)
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const float T = Numerator / Denominator;
+			if (Denominator >= 0.0f)
+			{
+				TRight = FMath::Min(TRight, T);
+			}
+			else
+			{
+				TLeft = FMath::Max(TLeft, T);
+			}
+
+			if (TLeft > TRight)
+			{
+				return false;
+			}
+		}
+
+		if (bDirectionOpt)
+		{
+			Result = Line.Point + ((OptVelocity | Line.Direction) > 0.0f ? TRight : TLeft) * Line.Direction;
+		}
+		else
+		{
+			const float T = FMath::Clamp(Line.Direction | (OptVelocity - Line.Point), TLeft, TRight);
+			Result = Line.Point + T * Line.Direction;
+		}
+		return true;
+	}
+
+	/** find velocity closest to preferred one satisfying all lines, returns index of first line which failed or number of lines */
+	static int32 Solve(const FLineArray& Lines, float Radius, const FVector2D& OptVelocity, bool bDirectionOpt, FVector2D& Result)
+	{
+		if (bDirectionOpt)
+		{
+			Result = OptVelocity * Radius;
+		}
+		else if (OptVelocity.SizeSquared() > FMath::Square(Radius))
+		{
+			Result = OptVelocity.GetSafeNormal() * Radius;
+		}
+		else
+		{
+			Result = OptVelocity;
+		}
+
+		for (int32 Idx = 0; Idx < Lines.Num(); Idx++)
+		{
+			if (Det(Lines[Idx].Direction, Lines[Idx].Point - Result) > 0.0f)
+			{
+				const FVector2D TempResult = Result;
+				if (!SolveOnLine(Lines, Idx, Radius, OptVelocity, bDirectionOpt, Result))
+				{
+					Result = TempResult;
+					return Idx;
+				}
+			}
+		}
+
+		return Lines.Num();
+	}
+
+	/** too crowded to satisfy everything, find velocity violating lines the least */
+	static void SolveCrowded(const FLineArray& Lines, int32 BeginLine, float Radius, FVector2D& Result)
+	{
+		float Distance = 0.0f;
+		FLineArray ProjLines;
+
+		for (int32 Idx = BeginLine; Idx < Lines.Num(); Idx++)
+		{
+			if (Det(Lines[Idx].Direction, Lines[Idx].Point - Result) <= Distance)
+			{
+				continue;
+			}
+
+			ProjLines.Reset();
+			for (int32 PrevIdx = 0; PrevIdx < Idx; PrevIdx++)
+			{
+				FLine Line;
+				const float Determinant = Det(Lines[Idx].Direction, Lines[PrevIdx].Direction);
+				if (FMath::Abs(Determinant) <= Epsilon)
+				{
+					// parallel lines pointing the same way add nothing
+					if ((Lines[Idx].Direction | Lines[PrevIdx].Direction) > 0.0f)
+					{
+						continue;
+					}
+					Line.Point = 0.5f * (Lines[Idx].Point + Lines[PrevIdx].Point);
+				}
+				else
+				{
+					Line.Point = Lines[Idx].Point + (Det(Lines[PrevIdx].Direction, Lines[Idx].Point - Lines[PrevIdx].Point) / Determinant) * Lines[Idx].Direction;
+				}
+
+				Line.Direction = (Lines[PrevIdx].Direction - Lines[Idx].Direction).GetSafeNormal();
+				ProjLines.Add(Line);
+			}
+
+			const FVector2D TempResult = Result;
+			if (Solve(ProjLines, Radius, FVector2D(-Lines[Idx].Direction.Y, Lines[Idx].Direction.X), true, Result) < ProjLines.Num())
+			{
+				// can only happen because of floating point error, keep what we had
+				Result = TempResult;
+			}
+
+			Distance = Det(Lines[Idx].Direction, Lines[Idx].Point - Result);
+		}
+	}
+
+	/** neighbour of an agent, sorted by distance */
+	struct FNeighbour
+	{
+		float DistSq;
+		int32 Index;
+
+		bool operator<(const FNeighbour& Other) const
+		{
+			return DistSq < Other.DistSq;
+		}
+	};
+}
+
+void FStrategyAvoidanceAgents::SetNum(int32 NewNum)
+{
+	Movements.SetNum(NewNum);
+	Positions.SetNum(NewNum);
+	Velocities.SetNum(NewNum);
+	PreferredVelocities.SetNum(NewNum);
+	NewVelocities.SetNum(NewNum);
+	Radii.SetNum(NewNum);
+	MaxSpeeds.SetNum(NewNum);
+	ActiveFlags.SetNum(NewNum);
+}
+
+UStrategyAIAvoidanceManager::UStrategyAIAvoidanceManager(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, NeighbourRadius(400.0f)
+	, MaxNeighbours(10)
+	, TimeHorizon(1.0f)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void UStrategyAIAvoidanceManager::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AStrategyGameState* const GameState = Cast<AStrategyGameState>(GetOwner());
+	if (GameState == nullptr || DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	const FStrategyUnitGrid& UnitGrid = GameState->GetUnitGrid();
+	const FStrategyUnitSnapshot& Snapshot = UnitGrid.GetSnapshot();
+	const int32 NumAgents = Snapshot.Num();
+	Agents.SetNum(NumAgents);
+
+	//在游戏线程里收集所有单位的状态，保持和快照一样的索引
+	int32 NumActive = 0;
+	for (int32 Idx = 0; Idx < NumAgents; Idx++)
+	{
+		AStrategyChar* const MyChar = Snapshot.Chars[Idx];
+		UStrategyMinionMovementComponent* const Movement = Cast<UStrategyMinionMovementComponent>(MyChar->GetCharacterMovement());
+		const FVector Location = MyChar->GetActorLocation();
+		const FVector Velocity = MyChar->GetVelocity();
+		const FVector PreferredVelocity = Movement != nullptr ? Movement->GetDesiredMoveVelocity() : FVector::ZeroVector;
+
+		Agents.Movements[Idx] = Movement;
+		Agents.Positions[Idx] = FVector2D(Location);
+		Agents.Velocities[Idx] = FVector2D(Velocity);
+		Agents.PreferredVelocities[Idx] = FVector2D(PreferredVelocity);
+		Agents.NewVelocities[Idx] = Agents.PreferredVelocities[Idx];
+		Agents.Radii[Idx] = MyChar->GetCapsuleComponent()->GetScaledCapsuleRadius();
+		Agents.MaxSpeeds[Idx] = Movement != nullptr ? Movement->GetMaxSpeed() : Velocity.Size2D();
+
+		const bool bActive = Movement != nullptr && MyChar->GetHealth() > 0 && !PreferredVelocity.IsNearlyZero();
+		Agents.ActiveFlags[Idx] = bActive ? 1 : 0;
+		NumActive += bActive ? 1 : 0;
+	}
+
+	if (NumActive == 0)
+	{
+		return;
+	}
+
+	// solving only reads gathered state and the grid, so every agent can run on its own core
+	ParallelFor(NumAgents, [&](int32 Idx)
+	{
+		if (Agents.ActiveFlags[Idx])
+		{
+			Agents.NewVelocities[Idx] = ComputeAvoidanceVelocity(UnitGrid, Idx, DeltaTime);
+		}
+	});
+
+	for (int32 Idx = 0; Idx < NumAgents; Idx++)
+	{
+		if (Agents.ActiveFlags[Idx])
+		{
+			const FVector2D& NewVelocity = Agents.NewVelocities[Idx];
+			Agents.Movements[Idx]->SetAvoidanceVelocity(FVector(NewVelocity.X, NewVelocity.Y, 0.0f));
+		}
+	}
+}
+
+FVector2D UStrategyAIAvoidanceManager::ComputeAvoidanceVelocity(const FStrategyUnitGrid& UnitGrid, int32 Idx, float DeltaTime) const
+{
+	using namespace StrategyAvoidance;
+
+	const FVector2D& Position = Agents.Positions[Idx];
+	const FVector2D& Velocity = Agents.Velocities[Idx];
+	const float Radius = Agents.Radii[Idx];
+
+	// closest neighbours of all teams, enemies are obstacles too
+	TArray<int32> NearbyUnits;
+	NearbyUnits.Reserve(32);
+	const FVector Center(Position.X, Position.Y, 0.0f);
+	for (uint8 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		UnitGrid.GatherUnits(Center, NeighbourRadius, TeamNum, NearbyUnits);
+	}
+
+	TArray<FNeighbour, TInlineAllocator<32> > Neighbours;
+	const float NeighbourRadiusSq = FMath::Square(NeighbourRadius);
+	for (int32 NearbyIdx = 0; NearbyIdx < NearbyUnits.Num(); NearbyIdx++)
+	{
+		const int32 OtherIdx = NearbyUnits[NearbyIdx];
+		const float DistSq = (Agents.Positions[OtherIdx] - Position).SizeSquared();
+		if (OtherIdx != Idx && DistSq < NeighbourRadiusSq)
+		{
+			FNeighbour Neighbour;
+			Neighbour.DistSq = DistSq;
+			Neighbour.Index = OtherIdx;
+			Neighbours.Add(Neighbour);
+		}
+	}
+
+	if (Neighbours.Num() > MaxNeighbours)
+	{
+		Neighbours.Sort();
+		Neighbours.SetNum(MaxNeighbours);
+	}
+
+	//为每个邻居构造一个允许速度的半平面
+	FLineArray Lines;
+	const float InvTimeHorizon = 1.0f / TimeHorizon;
+	for (int32 NeighbourIdx = 0; NeighbourIdx < Neighbours.Num(); NeighbourIdx++)
+	{
+		const int32 OtherIdx = Neighbours[NeighbourIdx].Index;
+		const FVector2D RelativePosition = Agents.Positions[OtherIdx] - Position;
+		const FVector2D RelativeVelocity = Velocity - Agents.Velocities[OtherIdx];
+		const float DistSq = RelativePosition.SizeSquared();
+		const float CombinedRadius = Radius + Agents.Radii[OtherIdx];
+		const float CombinedRadiusSq = FMath::Square(CombinedRadius);
+
+		FLine Line;
+		FVector2D U;
+		if (DistSq > CombinedRadiusSq)
+		{
+			// no collision yet, vector from cutoff center to relative velocity
+			const FVector2D W = RelativeVelocity - InvTimeHorizon * RelativePosition;
+			const float WLengthSq = W.SizeSquared();
+			const float DotProduct = W | RelativePosition;
+
+			if (DotProduct < 0.0f && FMath::Square(DotProduct) > CombinedRadiusSq * WLengthSq)
+			{
+				// project on cutoff circle
+				const float WLength = FMath::Sqrt(WLengthSq);
+				const FVector2D UnitW = W / WLength;
+				Line.Direction = FVector2D(UnitW.Y, -UnitW.X);
+				U = (CombinedRadius * InvTimeHorizon - WLength) * UnitW;
+			}
+			else
+			{
+				// project on legs
+				const float Leg = FMath::Sqrt(DistSq - CombinedRadiusSq);
+				if (Det(RelativePosition, W) > 0.0f)
+				{
+					Line.Direction = FVector2D(RelativePosition.X * Leg - RelativePosition.Y * CombinedRadius, RelativePosition.X * CombinedRadius + RelativePosition.Y * Leg) / DistSq;
+				}
+				else
+				{
+					Line.Direction = -FVector2D(RelativePosition.X * Leg + RelativePosition.Y * CombinedRadius, -RelativePosition.X * CombinedRadius + RelativePosition.Y * Leg) / DistSq;
+				}
+
+				U = (RelativeVelocity | Line.Direction) * Line.Direction - RelativeVelocity;
+			}
+		}
+		else
+		{
+			// already overlapping, get apart within this frame
+			const float InvTimeStep = 1.0f / DeltaTime;
+			const FVector2D W = RelativeVelocity - InvTimeStep * RelativePosition;
+			const float WLength = W.Size();
+			const FVector2D UnitW = WLength > Epsilon ? W / WLength : FVector2D(1.0f, 0.0f);
+			Line.Direction = FVector2D(UnitW.Y, -UnitW.X);
+			U = (CombinedRadius * InvTimeStep - WLength) * UnitW;
+		}
+
+		// moving neighbours take half of the effort, standing ones won't help at all
+		const float Responsibility = Agents.ActiveFlags[OtherIdx] ? 0.5f : 1.0f;
+		Line.Point = Velocity + Responsibility * U;
+		Lines.Add(Line);
+	}
+
+	FVector2D NewVelocity;
+	const float MaxSpeed = Agents.MaxSpeeds[Idx];
+	const int32 FailedLine = Solve(Lines, MaxSpeed, Agents.PreferredVelocities[Idx], false, NewVelocity);
+	if (FailedLine < Lines.Num())
+	{
+		SolveCrowded(Lines, FailedLine, MaxSpeed, NewVelocity);
+	}
+
+	return NewVelocity;
+}
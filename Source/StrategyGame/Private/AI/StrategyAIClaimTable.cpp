@@ -0,0 +1,67 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAIClaimTable.h"
+
+void FStrategyAIClaimTable::Claim(AStrategyAIController* Attacker, AStrategyAIController* Target)
+{
+	if (Attacker == nullptr || Target == nullptr)
+	{
+		return;
+	}
+
+	bool bAlreadyClaimed = false;
+	Claims.Add(FClaimKey(Attacker, Target), &bAlreadyClaimed);
+	if (!bAlreadyClaimed)
+	{
+		AttackerCounts.FindOrAdd(Target)++;
+		TargetsOfAttacker.Add(Attacker, Target);
+		AttackersOfTarget.Add(Target, Attacker);
+	}
+}
+
+void FStrategyAIClaimTable::UnClaim(AStrategyAIController* Attacker, AStrategyAIController* Target)
+{
+	if (Claims.Remove(FClaimKey(Attacker, Target)) == 0)
+	{
+		return;
+	}
+
+	int32& Count = AttackerCounts.FindChecked(Target);
+	if (--Count <= 0)
+	{
+		AttackerCounts.Remove(Target);
+	}
+
+	TargetsOfAttacker.RemoveSingle(Attacker, Target);
+	AttackersOfTarget.RemoveSingle(Target, Attacker);
+}
+
+void FStrategyAIClaimTable::ReleaseClaims(AStrategyAIController* Controller)
+{
+	TArray<AStrategyAIController*> Others;
+
+	TargetsOfAttacker.MultiFind(Controller, Others);
+	for (int32 Idx = 0; Idx < Others.Num(); Idx++)
+	{
+		UnClaim(Controller, Others[Idx]);
+	}
+
+	Others.Reset();
+	AttackersOfTarget.MultiFind(Controller, Others);
+	for (int32 Idx = 0; Idx < Others.Num(); Idx++)
+	{
+		UnClaim(Others[Idx], Controller);
+	}
+}
+
+bool FStrategyAIClaimTable::IsClaimedBy(const AStrategyAIController* Target, const AStrategyAIController* Attacker) const
+{
+	return Claims.Contains(FClaimKey(Attacker, Target));
+}
+
+int32 FStrategyAIClaimTable::GetNumberOfAttackers(const AStrategyAIController* Target) const
+{
+	const int32* Count = AttackerCounts.Find(Target);
+	return Count != nullptr ? *Count : 0;
+}
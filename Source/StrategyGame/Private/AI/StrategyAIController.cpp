@@ -4,8 +4,11 @@
 #include "StrategyAIController.h"
 #include "StrategyAIAction.h"
 #include "StrategyAISensingComponent.h"
+#include "StrategyAITargetingManager.h"
+#include "StrategyAIDecisionScheduler.h"
 #include "StrategyAIAction_AttackTarget.h"
 #include "StrategyAIAction_MoveToBrewery.h"
+#include "AI/Navigation/NavigationSystem.h"
 
 #include "VisualLogger/VisualLogger.h"
 
@@ -17,10 +20,30 @@ DEFINE_LOG_CATEGORY(LogStrategyAI);
  */
 AStrategyAIController::AStrategyAIController(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
+	, CombatLODDistance(800.0f)
+	, NearLODDistance(2500.0f)
+	, LODUpdateInterval(0.25f)
+	, CurrentLOD(EStrategyAILOD::Combat)
+	, LastLODUpdateTime(0.0f)
+	, PendingMoveLocation(FVector::ZeroVector)
+	, PendingMoveAcceptanceRadius(0.0f)
+	, PendingMoveId(0)
+	, NextMoveId(1)
+	, CachedActivations(0)
+	, ValidActivations(0)
+	, LastBreweryEpoch(0)
 	, bLogicEnabled(true)
+	, bDecisionPending(false)
+	, bDecisionHighPriority(false)
+	, bFactsChanged(true)
 {
 	SensingComponent = CreateDefaultSubobject<UStrategyAISensingComponent>(TEXT("SensingComp"));
 
+	LODTickIntervals[EStrategyAILOD::Combat] = 0.0f;
+	LODTickIntervals[EStrategyAILOD::Near] = 0.1f;
+	LODTickIntervals[EStrategyAILOD::Far] = 0.25f;
+	LODTickIntervals[EStrategyAILOD::Hidden] = 0.5f;
+
 	// add default action for most units
 	AllowedActions.Add(UStrategyAIAction_AttackTarget::StaticClass());
 	AllowedActions.Add(UStrategyAIAction_MoveToBrewery::StaticClass());
@@ -35,45 +58,97 @@ void AStrategyAIController::Possess(APawn* inPawn)
 {
 	Super::Possess(inPawn);
 	
-	/** Create instances of our possible actions */
+	//action对象是所有控制器共享的，每个控制器只保存自己的状态
+	/** Use shared instances of our possible actions, with fresh state for each */
 	AllActions.Reset();
 	for(int32 Idx=0; Idx < AllowedActions.Num(); Idx++ )
 	{
-		UStrategyAIAction* Action = NewObject<UStrategyAIAction>(this, AllowedActions[Idx]);
+		UStrategyAIAction* Action = AllowedActions[Idx]->GetDefaultObject<UStrategyAIAction>();
 		check(Action);
-		Action->SetController(this);
 		AllActions.Add(Action);
 	}
+	ActionStates.Reset();
+	ActionStates.AddDefaulted(AllActions.Num());
+	CurrentAction = NULL;
+	// controller may come back from minion pool, whatever it knew belongs to previous life
+	SensingComponent->KnownTargets.Reset();
+	InvalidateFacts(EStrategyAIFact::All);
 
 	AStrategyChar* const MyChar = Cast<AStrategyChar>(GetPawn());
 	if (MyChar != NULL && MyChar->GetCharacterMovement() != NULL)
 	{
-		MyChar->GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+		//怪物默认在导航网格上行走
+		MyChar->GetCharacterMovement()->SetDefaultMovementMode();
 	}
 
 	SetActorTickEnabled(true);
 	EnableLogic(true);
+
+	// start at full rate, first tick picks the real tier
+	CurrentLOD = EStrategyAILOD::Combat;
+	LastLODUpdateTime = 0.0f;
+	PrimaryActorTick.TickInterval = LODTickIntervals[CurrentLOD];
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != NULL && GameState->GetTargetingManager() != NULL)
+	{
+		GameState->GetTargetingManager()->RegisterController(this);
+	}
 }
 
 void AStrategyAIController::UnPossess()
 {
-	if (CurrentTarget != NULL)
+	ReleaseTargeting();
+
+	SetActorTickEnabled(false);
+	EnableLogic(false);
+	Super::UnPossess();
+}
+
+void AStrategyAIController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseTargeting();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AStrategyAIController::ReleaseTargeting()
+{
+	AbortPendingMove();
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != NULL)
 	{
-		//撤销锁定的目标
-		const APawn* TargetPawn = Cast<APawn>(CurrentTarget);
-		if (TargetPawn != NULL)
+		if (GameState->GetDecisionScheduler() != NULL)
 		{
-			AStrategyAIController* const AITarget = Cast<AStrategyAIController>(TargetPawn->Controller);
-			if (AITarget != NULL)
-			{
-				AITarget->UnClaimAsTarget(this);
-			}
+			GameState->GetDecisionScheduler()->CancelDecision(this);
+		}
+
+		//撤销所有锁定关系，包括自己锁定的和锁定自己的
+		GameState->GetClaimTable().ReleaseClaims(this);
+		if (GameState->GetTargetingManager() != NULL)
+		{
+			GameState->GetTargetingManager()->UnregisterController(this);
 		}
 	}
 
-	SetActorTickEnabled(false);
-	EnableLogic(false);
-	Super::UnPossess();
+	//离开小队，由下一个队员接任队长
+	SetSquad(TSharedPtr<FStrategySquad>());
+	CurrentTarget = NULL;
+}
+
+void AStrategyAIController::SetSquad(const TSharedPtr<FStrategySquad>& InSquad)
+{
+	if (Squad.IsValid())
+	{
+		Squad->RemoveMember(this);
+	}
+
+	Squad = InSquad;
+	if (Squad.IsValid())
+	{
+		Squad->AddMember(this);
+	}
 }
 
 uint8 AStrategyAIController::GetTeamNum() const
@@ -84,6 +159,12 @@ uint8 AStrategyAIController::GetTeamNum() const
 
 void AStrategyAIController::OnMoveCompleted(FAIRequestID RequestID, EPathFollowingResult::Type Result)
 {
+	// moves replaced by another one or aborted don't change where we are
+	if (Result == EPathFollowingResult::Success || Result == EPathFollowingResult::Blocked || Result == EPathFollowingResult::OffPath)
+	{
+		InvalidateFacts(EStrategyAIFact::Arrived);
+	}
+
 	if (CurrentAction != NULL && Result != EPathFollowingResult::Skipped)
 	{
 		OnMoveCompletedDelegate.ExecuteIfBound();
@@ -153,62 +234,16 @@ bool AStrategyAIController::IsTargetValid(AActor* InActor) const
 	return false;
 }
 
-void AStrategyAIController::SelectTarget()
+void AStrategyAIController::SetCurrentTarget(AActor* InTarget)
 {
-	if( GetPawn() == NULL )
+	const AActor* OldTarget = CurrentTarget;
+	if (OldTarget == InTarget)
 	{
 		return;
 	}
-	const FVector PawnLocation = GetPawn()->GetActorLocation();
-	AActor* BestUnit = NULL;
-	float BestUnitScore = 10000; //权值。权值越小越佳
 
-	for (int32 Idx = 0; Idx < SensingComponent->KnownTargets.Num(); Idx++)
-	{
-		AActor* const TestTarget = SensingComponent->KnownTargets[Idx].Get();
-		if (TestTarget == NULL || !IsTargetValid(TestTarget) )
-		{
-			continue;
-		}
-
-		/** don't care about targets with disabled logic */
-		const APawn* TestPawn = Cast<APawn>(TestTarget);
-		const AStrategyAIController *AITarget = (TestPawn ? Cast<AStrategyAIController>(TestPawn->Controller) : NULL);
-		if (AITarget != NULL && !AITarget->IsLogicEnabled())
-		{
-			continue;
-		}
-
-		//权值 = 距离的平方
-		float TargetScore = (PawnLocation - TestTarget->GetActorLocation()).SizeSquared();
-		if (CurrentTarget == TestTarget && TestTarget->IsA(AStrategyChar::StaticClass()) )
-		{
-			TargetScore -= FMath::Square(300.0f);
-		}
-
-		if (AITarget != NULL)
-		{
-			if (AITarget->IsClaimedBy(this)) //AITarget已经被锁定为目标了，优先选择他
-			{
-				TargetScore -= FMath::Square(300.0f);
-			}
-			else
-			{
-				// 如果目标已经被别人选中为目标了，就降低对他的权值
-				TargetScore += AITarget->GetNumberOfAttackers() * FMath::Square(900.0f);
-			}
-		}
-
-		if (BestUnit == NULL || BestUnitScore > TargetScore)
-		{
-			BestUnitScore = TargetScore;
-			BestUnit = TestTarget;
-		}
-	}
-
-	const AActor* OldTarget = CurrentTarget;
-	CurrentTarget = BestUnit;
-	if (CurrentTarget != NULL && OldTarget != CurrentTarget)
+	CurrentTarget = InTarget;
+	InvalidateFacts(EStrategyAIFact::CurrentTarget);
 	{
 		const APawn* OldTargetPawn = Cast<const APawn>(OldTarget);
 		AStrategyAIController* AITarget = OldTargetPawn != NULL ? Cast<AStrategyAIController>(OldTargetPawn->Controller) : NULL;
@@ -228,40 +263,34 @@ void AStrategyAIController::SelectTarget()
 	UE_VLOG(this, LogStrategyAI, Log, TEXT("Selected target: %s"), CurrentTarget != NULL ? *CurrentTarget->GetName() : TEXT("NONE") ); 
 }
 
-void AStrategyAIController::ClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController)
+void AStrategyAIController::ClaimAsTarget(AStrategyAIController* InController)
 {
-	ClaimedBy.AddUnique(InController);
-}
-
-void AStrategyAIController::UnClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController)
-{
-	for (int32 Idx = ClaimedBy.Num() - 1; Idx >= 0; Idx--)
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != NULL)
 	{
-		const AStrategyAIController* TestC = Cast<AStrategyAIController>(ClaimedBy[Idx].Get());
-		if (TestC != NULL && TestC == InController.Get())
-		{
-			ClaimedBy.RemoveAt(Idx);
-		}
+		GameState->GetClaimTable().Claim(InController, this);
 	}
 }
 
-bool AStrategyAIController::IsClaimedBy(TWeakObjectPtr<AStrategyAIController> InController) const
+void AStrategyAIController::UnClaimAsTarget(AStrategyAIController* InController)
 {
-	for (int32 Idx = ClaimedBy.Num() - 1; Idx >= 0; Idx--)
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != NULL)
 	{
-		const AStrategyAIController* TestC = Cast<AStrategyAIController>(ClaimedBy[Idx].Get());
-		if (TestC != NULL && TestC == InController.Get())
-		{
-			return true;
-		}
+		GameState->GetClaimTable().UnClaim(InController, this);
 	}
+}
 
-	return false;
+bool AStrategyAIController::IsClaimedBy(const AStrategyAIController* InController) const
+{
+	const AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	return GameState != NULL && GameState->GetClaimTable().IsClaimedBy(this, InController);
 }
 
 int32 AStrategyAIController::GetNumberOfAttackers() const
 {
-	return ClaimedBy.Num();
+	const AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	return GameState != NULL ? GameState->GetClaimTable().GetNumberOfAttackers(this) : 0;
 }
 
 void AStrategyAIController::Tick(float DeltaTime)
@@ -273,7 +302,7 @@ void AStrategyAIController::Tick(float DeltaTime)
 		{
 			if (CurrentAction != NULL)
 			{
-				CurrentAction->Abort();
+				CurrentAction->Abort(this, *GetActionState(CurrentAction));
 				CurrentAction= NULL;
 			}
 		}
@@ -281,45 +310,239 @@ void AStrategyAIController::Tick(float DeltaTime)
 	}
 	Super::Tick(DeltaTime);
 
-	if (CurrentAction != NULL && !CurrentAction->Tick(DeltaTime) && CurrentAction->IsSafeToAbort() )
+	if (CurrentAction != NULL)
 	{
-		UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action after Update"), *CurrentAction->GetName()); 
-		CurrentAction->Abort();
-		CurrentAction = NULL;
+		FStrategyAIActionState& State = *GetActionState(CurrentAction);
+		if (!CurrentAction->Tick(this, State, DeltaTime) && CurrentAction->IsSafeToAbort(State))
+		{
+			UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action after Update"), *CurrentAction->GetName()); 
+			CurrentAction->Abort(this, State);
+			CurrentAction = NULL;
+		}
+	}
+
+	// targets are assigned by the team, next assignment gives us a new one when ours is gone
+	if (CurrentTarget != NULL && !IsTargetValid(CurrentTarget))
+	{
+		SetCurrentTarget(NULL);
+	}
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != NULL && GameState->GetBreweryEpoch() != LastBreweryEpoch)
+	{
+		LastBreweryEpoch = GameState->GetBreweryEpoch();
+		InvalidateFacts(EStrategyAIFact::Brewery);
+	}
+
+	//没有任何条件变化时无需重新选择action
+	// action selection is spread over frames by the decision scheduler
+	if (CurrentAction == NULL || bFactsChanged)
+	{
+		if (GameState != NULL && GameState->GetDecisionScheduler() != NULL)
+		{
+			GameState->GetDecisionScheduler()->RequestDecision(this, CurrentLOD == EStrategyAILOD::Combat || CurrentAction == NULL);
+		}
+		else
+		{
+			UpdateDecision();
+		}
+	}
+
+	if (GetWorld()->GetTimeSeconds() - LastLODUpdateTime >= LODUpdateInterval)
+	{
+		UpdateLOD();
+	}
+}
+
+void AStrategyAIController::UpdateDecision()
+{
+	const AStrategyChar* MyChar = Cast<AStrategyChar>(GetPawn());
+	if (!IsLogicEnabled() || MyChar == NULL || MyChar->GetHealth() <= 0)
+	{
+		return;
 	}
 
 	//越靠前的action，越优先，当然，前提是现有的action可以被中断。
 	// select best action to execute
-	const bool bCanBreakCurrentAction = CurrentAction != NULL ? CurrentAction->IsSafeToAbort() : true;
+	const bool bCanBreakCurrentAction = CurrentAction != NULL ? CurrentAction->IsSafeToAbort(*GetActionState(CurrentAction)) : true;
 	if (bCanBreakCurrentAction)
 	{
+		bFactsChanged = false;
+
 		for (int32 Idx = 0; Idx < AllActions.Num(); Idx++)
 		{
-			if (CurrentAction == AllActions[Idx] && AllActions[Idx]->ShouldActivate())
+			if (CurrentAction == AllActions[Idx] && ShouldActivateAction(Idx))
 			{
 				break;
 			}
 
-			if (CurrentAction != AllActions[Idx] && AllActions[Idx]->ShouldActivate())
+			if (CurrentAction != AllActions[Idx] && ShouldActivateAction(Idx))
 			{
 				if (CurrentAction != NULL)
 				{
 					UE_VLOG(this, LogStrategyAI, Log, TEXT("Break on '%s' action, found better one '%s'"), *CurrentAction->GetName(), *AllActions[Idx]->GetName()); 
-					CurrentAction->Abort();
+					CurrentAction->Abort(this, *GetActionState(CurrentAction));
 				}
 
 				CurrentAction = AllActions[Idx];
 				if (CurrentAction != NULL)
 				{
 					UE_VLOG(this, LogStrategyAI, Log, TEXT("Execute on '%s' action"), *CurrentAction->GetName(), *AllActions[Idx]->GetName()); 
-					CurrentAction->Activate();
+					CurrentAction->Activate(this, ActionStates[Idx]);
 					break;
 				}
 			}
 		}
 	}
+}
+
+FStrategyAIActionState* AStrategyAIController::GetActionState(const UStrategyAIAction* Action)
+{
+	const int32 Idx = AllActions.Find(const_cast<UStrategyAIAction*>(Action));
+	return ActionStates.IsValidIndex(Idx) ? &ActionStates[Idx] : NULL;
+}
+
+void AStrategyAIController::InvalidateFacts(uint8 Facts)
+{
+	for (int32 Idx = 0; Idx < AllActions.Num(); Idx++)
+	{
+		if (AllActions[Idx]->GetFactDependencies() & Facts)
+		{
+			ValidActivations &= ~(1u << Idx);
+			bFactsChanged = true;
+		}
+	}
+}
+
+bool AStrategyAIController::ShouldActivateAction(int32 Idx)
+{
+	const uint32 ActionBit = 1u << Idx;
+	if ((ValidActivations & ActionBit) == 0)
+	{
+		ValidActivations |= ActionBit;
+		if (AllActions[Idx]->ShouldActivate(this))
+		{
+			CachedActivations |= ActionBit;
+		}
+		else
+		{
+			CachedActivations &= ~ActionBit;
+		}
+	}
+
+	return (CachedActivations & ActionBit) != 0;
+}
+
+void AStrategyAIController::UpdateLOD()
+{
+	const AStrategyChar* const MyChar = Cast<AStrategyChar>(GetPawn());
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (MyChar == NULL || GameState == NULL)
+	{
+		return;
+	}
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	LastLODUpdateTime = CurrentTime;
+
+	const float NearestEnemyDistSq = GameState->GetUnitGrid().GetNearestEnemyDistSquared(MyChar->GetActorLocation(), NearLODDistance, GetTeamNum());
+
+	//敌人在附近或者正在被攻击时全速更新；离敌人远且不在屏幕上时降到最低频率
+	EStrategyAILOD::Type NewLOD = EStrategyAILOD::Hidden;
+	if (NearestEnemyDistSq <= FMath::Square(CombatLODDistance) || GetNumberOfAttackers() > 0)
+	{
+		NewLOD = EStrategyAILOD::Combat;
+	}
+	else if (NearestEnemyDistSq <= FMath::Square(NearLODDistance))
+	{
+		NewLOD = EStrategyAILOD::Near;
+	}
+	else if (MyChar->GetMesh() != NULL && CurrentTime - MyChar->GetMesh()->LastRenderTime < 0.2f)
+	{
+		NewLOD = EStrategyAILOD::Far;
+	}
+
+	if (NewLOD != CurrentLOD)
+	{
+		UE_VLOG(this, LogStrategyAI, Log, TEXT("LOD changed from %d to %d"), int32(CurrentLOD), int32(NewLOD));
+		CurrentLOD = NewLOD;
+
+		// actions are ticked by us, so they follow the same rate; movement is updated by the pawn every frame
+		PrimaryActorTick.TickInterval = LODTickIntervals[CurrentLOD];
+	}
+}
+
+void AStrategyAIController::MoveToActorAsync(AActor* Goal, float AcceptanceRadius)
+{
+	PendingMoveId = NextMoveId++;
+	PendingMoveGoal = Goal;
+	PendingMoveLocation = FVector::ZeroVector;
+	PendingMoveAcceptanceRadius = AcceptanceRadius;
+	RequestPendingMovePath();
+}
+
+void AStrategyAIController::MoveToLocationAsync(const FVector& Dest, float AcceptanceRadius)
+{
+	// same as synchronous move, aim at navigation closest to destination
+	FVector GoalLocation = Dest;
+	UNavigationSystem* const NavSys = GetWorld()->GetNavigationSystem();
+	FNavLocation ProjectedLocation;
+	if (NavSys != NULL && NavSys->ProjectPointToNavigation(Dest, ProjectedLocation, INVALID_NAVEXTENT, &GetNavAgentPropertiesRef()))
+	{
+		GoalLocation = ProjectedLocation.Location;
+	}
+
+	PendingMoveId = NextMoveId++;
+	PendingMoveGoal = NULL;
+	PendingMoveLocation = GoalLocation;
+	PendingMoveAcceptanceRadius = AcceptanceRadius;
+	RequestPendingMovePath();
+}
+
+void AStrategyAIController::AbortPendingMove()
+{
+	PendingMoveId = 0;
+	PendingMoveGoal = NULL;
+}
+
+void AStrategyAIController::RequestPendingMovePath()
+{
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState == NULL)
+	{
+		OnPendingMovePathFound(NULL, PendingMoveId);
+		return;
+	}
 
-	SelectTarget();
+	//寻路结果可能立即返回（命中缓存），也可能在之后的帧返回
+	GameState->GetPathCache().RequestPath(this, PendingMoveGoal.Get(), PendingMoveLocation,
+		FOnStrategyPathFound::CreateUObject(this, &AStrategyAIController::OnPendingMovePathFound, PendingMoveId));
+}
+
+void AStrategyAIController::OnPendingMovePathFound(FNavPathSharedPtr Path, uint32 MoveId)
+{
+	// move was replaced or aborted while we waited
+	if (MoveId == 0 || MoveId != PendingMoveId)
+	{
+		return;
+	}
+
+	AActor* const Goal = PendingMoveGoal.Get();
+	const bool bLostGoal = PendingMoveGoal.IsStale();
+	PendingMoveId = 0;
+	PendingMoveGoal = NULL;
+
+	if (!Path.IsValid() || bLostGoal || GetPawn() == NULL)
+	{
+		// report failure the same way as a failed synchronous move
+		OnMoveCompleted(FAIRequestID::InvalidRequest, EPathFollowingResult::Invalid);
+		return;
+	}
+
+	FAIMoveRequest MoveRequest = Goal != NULL ? FAIMoveRequest(Goal) : FAIMoveRequest(PendingMoveLocation);
+	MoveRequest.SetAcceptanceRadius(PendingMoveAcceptanceRadius);
+	MoveRequest.SetUsePathfinding(true);
+	RequestMove(MoveRequest, Path);
 }
 
 void AStrategyAIController::EnableLogic(bool bEnable)
@@ -348,6 +571,15 @@ void AStrategyAIController::GrabDebugSnapshot(FVisualLogEntry* Snapshot) const
 	MyCategory.Category = TEXT("StrategyAIController");
 	MyCategory.Add(TEXT("CurrentAction"), CurrentAction != NULL ? *CurrentAction->GetName() : TEXT("NONE"));
 	MyCategory.Add(TEXT("CurrentTarget"), *GetDebugName(CurrentTarget));
+	MyCategory.Add(TEXT("LOD"), FString::FromInt(CurrentLOD));
+
+	const AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != NULL)
+	{
+		MyCategory.Add(TEXT("PathCacheHits"), FString::FromInt(GameState->GetPathCache().GetNumHits()));
+		MyCategory.Add(TEXT("PathCacheMisses"), FString::FromInt(GameState->GetPathCache().GetNumMisses()));
+		MyCategory.Add(TEXT("PathCacheCoalesced"), FString::FromInt(GameState->GetPathCache().GetNumCoalesced()));
+	}
 
 	AStrategyChar* MyChar = Cast<AStrategyChar>(GetPawn());
 	if (MyChar)
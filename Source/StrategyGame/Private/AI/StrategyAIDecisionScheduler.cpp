@@ -0,0 +1,97 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAIDecisionScheduler.h"
+#include "StrategyAIController.h"
+
+UStrategyAIDecisionScheduler::UStrategyAIDecisionScheduler(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, MaxDecisionTimePerFrame(0.5f)
+	, NormalBudgetShare(0.25f)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void UStrategyAIDecisionScheduler::RequestDecision(AStrategyAIController* Controller, bool bHighPriority)
+{
+	if (Controller == nullptr)
+	{
+		return;
+	}
+
+	if (Controller->IsDecisionPending())
+	{
+		// entered combat while waiting, don't keep it behind everyone else
+		if (!bHighPriority || Controller->IsDecisionHighPriority())
+		{
+			return;
+		}
+		NormalQueue.Remove(Controller);
+	}
+
+	Controller->SetDecisionPending(true, bHighPriority);
+	if (bHighPriority)
+	{
+		PriorityQueue.Add(Controller);
+	}
+	else
+	{
+		NormalQueue.Add(Controller);
+	}
+}
+
+void UStrategyAIDecisionScheduler::CancelDecision(AStrategyAIController* Controller)
+{
+	if (Controller != nullptr && Controller->IsDecisionPending())
+	{
+		Controller->SetDecisionPending(false);
+		PriorityQueue.Remove(Controller);
+		NormalQueue.Remove(Controller);
+	}
+}
+
+void UStrategyAIDecisionScheduler::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const double Budget = MaxDecisionTimePerFrame / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + Budget;
+	const double PriorityEndTime = StartTime + Budget * (1.0f - FMath::Clamp(NormalBudgetShare, 0.0f, 1.0f));
+
+	//先处理战斗中的单位，但每帧都给其他单位留一部分预算，避免它们一直等待
+	ServiceQueue(PriorityQueue, PriorityEndTime);
+	ServiceQueue(NormalQueue, EndTime);
+
+	// time other units didn't need goes back to combat
+	if (PriorityQueue.Num() > 0 && FPlatformTime::Seconds() < EndTime)
+	{
+		ServiceQueue(PriorityQueue, EndTime);
+	}
+}
+
+bool UStrategyAIDecisionScheduler::ServiceQueue(TArray<AStrategyAIController*>& Queue, double EndTime)
+{
+	int32 NumServiced = 0;
+	bool bOutOfTime = false;
+	while (NumServiced < Queue.Num())
+	{
+		// budget is checked before each decision, so at least one runs every frame
+		if (NumServiced > 0 && FPlatformTime::Seconds() >= EndTime)
+		{
+			bOutOfTime = true;
+			break;
+		}
+
+		AStrategyAIController* const Controller = Queue[NumServiced++];
+		if (Controller != nullptr)
+		{
+			Controller->SetDecisionPending(false);
+			Controller->UpdateDecision();
+		}
+	}
+
+	Queue.RemoveAt(0, NumServiced, false);
+	return !bOutOfTime;
+}
@@ -5,18 +5,47 @@
 #include "StrategyBuilding_Brewery.h"
 #include "StrategyGameBlueprintLibrary.h"
 #include "StrategyAttachment.h"
+#include "StrategyAIController.h"
+#include "StrategySquad.h"
+#include "StrategyMinionPool.h"
+#include "StrategyWaveSchedule.h"
+#include "AI/Navigation/NavigationSystem.h"
+
+namespace StrategySpawnSlots
+{
+	/** number of spawn slots in front of brewery */
+	const int32 NumSlots = 6;
+
+	/** distance between two neighbouring slots */
+	const float Spacing = 45.0f;
+
+	// let's give better order for our spots
+	const int32 Order[NumSlots] = {3,2,4,1,5,0};
+
+	/** get lateral offset of slot from brewery axis */
+	float GetOffset(int32 Slot)
+	{
+		return (Slot - NumSlots/2) * Spacing;
+	}
+}
 
 UStrategyAIDirector::UStrategyAIDirector(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 	, WaveSize(3)
+	, WaveSchedule(nullptr)
 	, RadiusToSpawnOn(200)
+	, bSpawnSlotsDirty(true)
+	, LastSpawnSlot(0)
+	, CurrentPlanWave(INDEX_NONE)
+	, bLoadingSpawnClasses(false)
 	, CustomScale(1.0)
 	, AnimationRate(1)
 	, NextSpawnTime(0)
 	, MyTeamNum(EStrategyTeam::Unknown)
 {
-	PrimaryComponentTick.bCanEverTick = true;
-	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// spawns are driven by timer, idle directors cost nothing per frame
+	PrimaryComponentTick.bCanEverTick = false;
+	bWantsBeginPlay = true;
 
 	// @todo, why aren't these set in BuffData ctor?
 	BuffModifier.BuffData.AttackMin = 0;
@@ -45,7 +74,207 @@ void UStrategyAIDirector::OnGameplayStateChange(EGameplayState::Type NewState)
 	{
 		Activate();
 		NextSpawnTime = 0;
+		UpdateEnemyBrewery();
+		BuildSpawnPlan();
+		StartPlannedWave(0);
+
+		// start slot comes from the same stream as intervals, seeded schedules stay repeatable
+		LastSpawnSlot = SpawnRandomStream.RandRange(0, StrategySpawnSlots::NumSlots - 1);
+
+		// have some minions ready before first wave, classes still streaming in are pooled once loaded
+		RequestSpawnClasses();
+		PrewarmMinionPool();
+		ScheduleSpawn();
+	}
+}
+
+void UStrategyAIDirector::PrewarmMinionPool()
+{
+	const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (Owner == nullptr || GameState == nullptr || GameState->GetMinionPool() == nullptr)
+	{
+		return;
+	}
+
+	GameState->GetMinionPool()->Prewarm(Owner->MinionCharClass, Owner->GetActorLocation());
+	for (int32 Idx = 0; Idx < SpawnPlan.Num(); Idx++)
+	{
+		GameState->GetMinionPool()->Prewarm(SpawnPlan[Idx].MinionClass.Get(), Owner->GetActorLocation());
+	}
+}
+
+void UStrategyAIDirector::AddPendingClass(const FStringAssetReference& ClassRef, TArray<FStringAssetReference>& OutClassRefs)
+{
+	if (ClassRef.IsValid() && ClassRef.ResolveObject() == nullptr)
+	{
+		OutClassRefs.AddUnique(ClassRef);
+	}
+}
+
+bool UStrategyAIDirector::AreSpawnClassesLoaded() const
+{
+	// brewery's MinionCharClass is a hard reference, it's always resident
+	return !WaveMinionClass.IsPending() && !DefaultWeapon.IsPending() && !DefaultArmor.IsPending();
+}
+
+void UStrategyAIDirector::RequestSpawnClasses()
+{
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (bLoadingSpawnClasses || GameState == nullptr)
+	{
+		return;
+	}
+
+	RequestedSpawnClasses.Reset();
+	AddPendingClass(WaveMinionClass.ToStringReference(), RequestedSpawnClasses);
+	AddPendingClass(DefaultWeapon.ToStringReference(), RequestedSpawnClasses);
+	AddPendingClass(DefaultArmor.ToStringReference(), RequestedSpawnClasses);
+	if (RequestedSpawnClasses.Num() > 0)
+	{
+		bLoadingSpawnClasses = true;
+		GameState->GetStreamableManager().RequestAsyncLoad(RequestedSpawnClasses, FStreamableDelegate::CreateUObject(this, &UStrategyAIDirector::OnSpawnClassesLoaded));
+	}
+}
+
+void UStrategyAIDirector::OnSpawnClassesLoaded()
+{
+	bLoadingSpawnClasses = false;
+
+	//加载失败的类重试也不会出现，改用酿酒厂的小兵，去掉缺失的装备，继续出这一波
+	FStrategySpawnPlanWave* const PlanWave = SpawnPlan.IsValidIndex(CurrentPlanWave) ? &SpawnPlan[CurrentPlanWave] : nullptr;
+	const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
+	if (WaveMinionClass.IsPending() && RequestedSpawnClasses.Contains(WaveMinionClass.ToStringReference()))
+	{
+		UE_LOG(LogGame, Warning, TEXT("Failed to load minion class %s in %s, using brewery's minions"), *WaveMinionClass.ToStringReference().ToString(), *GetNameSafe(Owner));
+		WaveMinionClass = TAssetSubclassOf<AStrategyChar>();
+		if (PlanWave != nullptr)
+		{
+			PlanWave->MinionClass = TAssetSubclassOf<AStrategyChar>(Owner != nullptr ? *Owner->MinionCharClass : nullptr);
+		}
+	}
+	if (DefaultWeapon.IsPending() && RequestedSpawnClasses.Contains(DefaultWeapon.ToStringReference()))
+	{
+		UE_LOG(LogGame, Warning, TEXT("Failed to load weapon class %s in %s, spawning without weapon"), *DefaultWeapon.ToStringReference().ToString(), *GetNameSafe(Owner));
+		DefaultWeapon = TAssetSubclassOf<UStrategyAttachment>();
+		if (PlanWave != nullptr)
+		{
+			PlanWave->WeaponClass = DefaultWeapon;
+		}
 	}
+	if (DefaultArmor.IsPending() && RequestedSpawnClasses.Contains(DefaultArmor.ToStringReference()))
+	{
+		UE_LOG(LogGame, Warning, TEXT("Failed to load armor class %s in %s, spawning without armor"), *DefaultArmor.ToStringReference().ToString(), *GetNameSafe(Owner));
+		DefaultArmor = TAssetSubclassOf<UStrategyAttachment>();
+		if (PlanWave != nullptr)
+		{
+			PlanWave->ArmorClass = DefaultArmor;
+		}
+	}
+	RequestedSpawnClasses.Reset();
+
+	// wave may have changed while loading, stream in its classes as well
+	RequestSpawnClasses();
+
+	PrewarmMinionPool();
+	ScheduleSpawn();
+}
+
+void UStrategyAIDirector::PreloadPlannedWave(int32 WaveIdx)
+{
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (!SpawnPlan.IsValidIndex(WaveIdx) || GameState == nullptr)
+	{
+		return;
+	}
+
+	const FStrategySpawnPlanWave& Wave = SpawnPlan[WaveIdx];
+	TArray<FStringAssetReference> ClassRefs;
+	AddPendingClass(Wave.MinionClass.ToStringReference(), ClassRefs);
+	AddPendingClass(Wave.WeaponClass.ToStringReference(), ClassRefs);
+	AddPendingClass(Wave.ArmorClass.ToStringReference(), ClassRefs);
+	if (ClassRefs.Num() > 0)
+	{
+		GameState->GetStreamableManager().RequestAsyncLoad(ClassRefs, FStreamableDelegate::CreateUObject(this, &UStrategyAIDirector::PrewarmMinionPool));
+	}
+}
+
+void UStrategyAIDirector::BuildSpawnPlan()
+{
+	SpawnPlan.Reset();
+	CurrentPlanWave = INDEX_NONE;
+
+	const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
+	if (WaveSchedule == nullptr || Owner == nullptr)
+	{
+		SpawnRandomStream.GenerateNewSeed();
+		return;
+	}
+
+	// fixed seed gives the same spawn intervals every run
+	if (WaveSchedule->RandomSeed != 0)
+	{
+		SpawnRandomStream.Initialize(WaveSchedule->RandomSeed);
+	}
+	else
+	{
+		SpawnRandomStream.GenerateNewSeed();
+	}
+
+	//比赛开始时把出怪计划展开，出怪时不再需要查询
+	for (int32 Idx = 0; Idx < WaveSchedule->Waves.Num(); Idx++)
+	{
+		const FStrategyWaveInfo& WaveInfo = WaveSchedule->Waves[Idx];
+		const TAssetSubclassOf<AStrategyChar> MinionClass = !WaveInfo.MinionClass.IsNull() ? WaveInfo.MinionClass : TAssetSubclassOf<AStrategyChar>(*Owner->MinionCharClass);
+		if (WaveInfo.NumMinions <= 0 || MinionClass.IsNull())
+		{
+			continue;
+		}
+
+		FStrategySpawnPlanWave Wave;
+		Wave.MinionClass = MinionClass;
+		Wave.WeaponClass = WaveInfo.WeaponClass;
+		Wave.ArmorClass = WaveInfo.ArmorClass;
+		Wave.Buff = WaveInfo.Buff;
+		Wave.CustomScale = WaveInfo.CustomScale;
+		Wave.AnimationRate = WaveInfo.AnimationRate;
+		Wave.Delay = WaveInfo.Delay;
+		Wave.NumMinions = WaveInfo.NumMinions;
+		SpawnPlan.Add(Wave);
+	}
+}
+
+void UStrategyAIDirector::StartPlannedWave(int32 WaveIdx)
+{
+	if (WaveIdx >= SpawnPlan.Num())
+	{
+		if (WaveSchedule == nullptr || !WaveSchedule->bLoop || SpawnPlan.Num() == 0)
+		{
+			// schedule is over, waves are up to Blueprint again
+			CurrentPlanWave = INDEX_NONE;
+			WaveMinionClass = TAssetSubclassOf<AStrategyChar>();
+			return;
+		}
+		WaveIdx = 0;
+	}
+
+	CurrentPlanWave = WaveIdx;
+	const FStrategySpawnPlanWave& Wave = SpawnPlan[WaveIdx];
+	WaveSize = Wave.NumMinions;
+	WaveMinionClass = Wave.MinionClass;
+	DefaultWeapon = Wave.WeaponClass;
+	DefaultArmor = Wave.ArmorClass;
+	BuffModifier = Wave.Buff;
+	CustomScale = Wave.CustomScale;
+	AnimationRate = Wave.AnimationRate;
+	NextSpawnTime = FMath::Max(NextSpawnTime, GetWorld()->GetTimeSeconds() + Wave.Delay);
+
+	//当前波次在等待期间加载，下一波的类提前在后台加载
+	RequestSpawnClasses();
+	PreloadPlannedWave(WaveSchedule != nullptr && WaveSchedule->bLoop ? (WaveIdx + 1) % SpawnPlan.Num() : WaveIdx + 1);
+
+	// new wave size, spawn timer may have lapsed
+	ScheduleSpawn();
 }
 
 AStrategyBuilding_Brewery* UStrategyAIDirector::GetEnemyBrewery() const
@@ -60,7 +289,7 @@ void UStrategyAIDirector::SetDefaultArmor(UBlueprint* InArmor)
 
 void UStrategyAIDirector::SetDefaultArmorClass(TSubclassOf<UStrategyAttachment> InArmor)
 {
-	DefaultArmor = InArmor;
+	DefaultArmor = *InArmor;
 }
 
 void UStrategyAIDirector::SetDefaultWeapon(UBlueprint* InWeapon)
@@ -70,7 +299,7 @@ void UStrategyAIDirector::SetDefaultWeapon(UBlueprint* InWeapon)
 
 void UStrategyAIDirector::SetDefaultWeaponClass(TSubclassOf<UStrategyAttachment> InWeapon)
 {
-	DefaultWeapon = InWeapon;
+	DefaultWeapon = *InWeapon;
 }
 
 void UStrategyAIDirector::SetBuffModifier(AStrategyChar* InChar, int32 AttackMin, int32 AttackMax, int32 DamageReduction, int32 MaxHealthBonus, int32 HealthRegen, float Speed, int32 DrunkLevel, float Duration, bool bInfiniteDuration, float InCustomScale, float InAnimaRate)
@@ -87,87 +316,182 @@ void UStrategyAIDirector::SetBuffModifier(AStrategyChar* InChar, int32 AttackMin
 	AnimationRate = InAnimaRate;
 }
 
-struct OffsetsGeneratorHelper
+void UStrategyAIDirector::BeginPlay()
 {
-	float Offset[6];
-	int32 LastIndex;
+	Super::BeginPlay();
+
+	UpdateSpawnSlots();
 
-	OffsetsGeneratorHelper()
-		: LastIndex( FMath::RandRange(0, 5) )
+	UNavigationSystem* const NavSys = GetWorld()->GetNavigationSystem();
+	if (NavSys != nullptr)
 	{
-		TArray<float> AllSlots;
-		for (int32 Idx = 0; Idx < 6; Idx++)
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UStrategyAIDirector::OnNavigationGenerated);
+	}
+}
+
+void UStrategyAIDirector::OnNavigationGenerated(ANavigationData* NavData)
+{
+	bSpawnSlotsDirty = true;
+}
+
+void UStrategyAIDirector::UpdateSpawnSlots()
+{
+	const AActor* const Owner = GetOwner();
+	if (Owner == nullptr)
+	{
+		return;
+	}
+
+	bSpawnSlotsDirty = false;
+	SpawnSlots.SetNum(StrategySpawnSlots::NumSlots);
+
+	const FVector X = Owner->GetTransform().GetScaledAxis( EAxis::X );
+	const FVector Y = Owner->GetTransform().GetScaledAxis( EAxis::Y );
+	// long enough for minions scaled up to twice their size
+	const FVector TraceOffset(0.0f, 0.0f, RadiusToSpawnOn);
+	FCollisionObjectQueryParams ObjectParams( FCollisionObjectQueryParams::AllStaticObjects );
+
+	//每个出生点只需要检测一次地面高度
+	for (int32 Idx = 0; Idx < SpawnSlots.Num(); Idx++)
+	{
+		const FVector Loc = Owner->GetActorLocation() + X * RadiusToSpawnOn + Y * StrategySpawnSlots::GetOffset(Idx);
+
+		FHitResult Hit;
+		GetWorld()->LineTraceSingleByObjectType(Hit, Loc + TraceOffset, Loc - TraceOffset, ObjectParams);
+		SpawnSlots[Idx].bOnGround = Hit.Actor.IsValid();
+		SpawnSlots[Idx].Location = SpawnSlots[Idx].bOnGround ? Hit.Location : Loc;
+	}
+}
+
+int32 UStrategyAIDirector::PickSpawnSlot(float ClearanceRadius)
+{
+	const AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState == nullptr)
+	{
+		LastSpawnSlot = (LastSpawnSlot + 1) % StrategySpawnSlots::NumSlots;
+		return StrategySpawnSlots::Order[LastSpawnSlot];
+	}
+
+	const FStrategyUnitGrid& UnitGrid = GameState->GetUnitGrid();
+	const FStrategyUnitSnapshot& Snapshot = UnitGrid.GetSnapshot();
+	const float ClearanceRadiusSq = FMath::Square(ClearanceRadius);
+
+	//从上一次的出生点之后开始找，优先选择没有被占用的，都被占用时选择人最少的
+	int32 BestOrderIdx = INDEX_NONE;
+	int32 BestNumUnits = MAX_int32;
+	TArray<int32> NearbyUnits;
+	for (int32 Step = 1; Step <= StrategySpawnSlots::NumSlots && BestNumUnits > 0; Step++)
+	{
+		const int32 OrderIdx = (LastSpawnSlot + Step) % StrategySpawnSlots::NumSlots;
+		const FVector& SlotLocation = SpawnSlots[StrategySpawnSlots::Order[OrderIdx]].Location;
+
+		NearbyUnits.Reset();
+		for (uint8 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+		{
+			UnitGrid.GatherUnits(SlotLocation, ClearanceRadius, TeamNum, NearbyUnits);
+		}
+
+		//单位只占用离它最近的出生点，站在一个出生点上不会让相邻的出生点也被占用
+		int32 NumUnits = 0;
+		for (int32 Idx = 0; Idx < NearbyUnits.Num(); Idx++)
 		{
-			AllSlots.Add((Idx - 6/2) * 45);
+			const FVector& UnitLocation = Snapshot.Locations[NearbyUnits[Idx]];
+			const float DistSq = FVector::DistSquared2D(UnitLocation, SlotLocation);
+			if (DistSq < ClearanceRadiusSq && GetClosestSpawnSlot(UnitLocation) == StrategySpawnSlots::Order[OrderIdx])
+			{
+				NumUnits++;
+			}
 		}
 
-		// let's give better order for our spots
-		const int32 Indexes[6] = {3,2,4,1,5,0};
-		for(int32 Idx = 0; Idx < 6; Idx++)
+		if (NumUnits < BestNumUnits)
 		{
-			Offset[Idx] = AllSlots[Indexes[Idx]];
+			BestNumUnits = NumUnits;
+			BestOrderIdx = OrderIdx;
 		}
 	}
 
-	float GetOffset()
+	LastSpawnSlot = BestOrderIdx;
+	return StrategySpawnSlots::Order[BestOrderIdx];
+}
+
+int32 UStrategyAIDirector::GetClosestSpawnSlot(const FVector& Location) const
+{
+	int32 BestSlot = INDEX_NONE;
+	float BestDistSq = MAX_FLT;
+	for (int32 Idx = 0; Idx < SpawnSlots.Num(); Idx++)
 	{
-		LastIndex = ++LastIndex >= 6 ? 0 : LastIndex;
-		return Offset[LastIndex];
+		const float DistSq = FVector::DistSquared2D(Location, SpawnSlots[Idx].Location);
+		if (DistSq < BestDistSq)
+		{
+			BestDistSq = DistSq;
+			BestSlot = Idx;
+		}
 	}
-};
+	return BestSlot;
+}
 
 void UStrategyAIDirector::SpawnMinions()
 {
-	static OffsetsGeneratorHelper OffsetsGenerator;
-
-	const bool bShoudSpawnNewUnits = GetWorld()->GetTimeSeconds() > NextSpawnTime;
+	const bool bShoudSpawnNewUnits = GetWorld()->GetTimeSeconds() >= NextSpawnTime;
 	if (!bShoudSpawnNewUnits)
 	{
 		return;
 	}
 
-	if (EnemyBrewery == nullptr)
-	{
-		const EStrategyTeam::Type EnemyTeamNum = (MyTeamNum == EStrategyTeam::Player ? EStrategyTeam::Enemy : EStrategyTeam::Player);
-		const FPlayerData* const EnemyTeamData = GetWorld()->GetGameState<AStrategyGameState>()->GetPlayerData(EnemyTeamNum);
-		if (EnemyTeamData != nullptr && EnemyTeamData->Brewery != nullptr)
-		{
-			EnemyBrewery = EnemyTeamData->Brewery;
-		}
-	}
+	UpdateEnemyBrewery();
 
 	if(WaveSize > 0)
 	{
 		// find best place on ground to spawn at
 		const AStrategyBuilding_Brewery* const Owner = Cast<AStrategyBuilding_Brewery>(GetOwner());
 		check(Owner);
-		bool bSpawnedNewMinion = false;
-		if( Owner->MinionCharClass != nullptr )
+
+		// never load classes synchronously here, wait until they are streamed in
+		if (!AreSpawnClassesLoaded())
 		{
-			FVector Loc = Owner->GetActorLocation();
-			const FVector X = Owner->GetTransform().GetScaledAxis( EAxis::X );
-			const FVector Y = Owner->GetTransform().GetScaledAxis( EAxis::Y );
-			Loc += X * RadiusToSpawnOn +  Y * OffsetsGenerator.GetOffset();
+			RequestSpawnClasses();
+			NextSpawnTime = GetWorld()->GetTimeSeconds() + 0.1f;
+			return;
+		}
 
-			const FVector Scale(CustomScale);
-			const FVector TraceOffset(0.0f,0.0f,RadiusToSpawnOn * 0.5 * Scale.Z);
-			FHitResult Hit;
-			FCollisionObjectQueryParams ObjectParams( FCollisionObjectQueryParams::AllStaticObjects );
-			GetWorld()->LineTraceSingleByObjectType(Hit, Loc + TraceOffset, Loc - TraceOffset, ObjectParams);
-			if (Hit.Actor.IsValid())
+		bool bSpawnedNewMinion = false;
+		const TSubclassOf<AStrategyChar> MinionClass = WaveMinionClass.IsNull() ? *Owner->MinionCharClass : WaveMinionClass.Get();
+		UClass* const WeaponClass = DefaultWeapon.Get();
+		UClass* const ArmorClass = DefaultArmor.Get();
+		if( MinionClass != nullptr )
+		{
+			if (bSpawnSlotsDirty)
 			{
-				Loc = Hit.Location + FVector(0.0f,0.0f,Scale.Z * 10.0f);
+				UpdateSpawnSlots();
 			}
-			AStrategyChar* StrategyChar = Owner->MinionCharClass->GetDefaultObject<AStrategyChar>();
+
+			const FVector Scale(CustomScale);
+			AStrategyChar* StrategyChar = MinionClass->GetDefaultObject<AStrategyChar>();
 			const float CapsuleHalfHeight = StrategyChar->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
 			const float CapsuleRadius = StrategyChar->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
-			Loc = Loc + FVector( 0.0f,0.0f,Scale.Z * CapsuleHalfHeight);
 
-			// and spawn our minion
-			FActorSpawnParameters SpawnInfo;
-			SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			// ground below slots is already known, pick one nobody stands on
+			const FStrategySpawnSlot& Slot = SpawnSlots[PickSpawnSlot(Scale.X * CapsuleRadius + StrategySpawnSlots::Spacing)];
+			FVector Loc = Slot.Location;
+			if (Slot.bOnGround)
+			{
+				Loc += FVector(0.0f,0.0f,Scale.Z * 10.0f);
+			}
+			Loc = Loc + FVector( 0.0f,0.0f,Scale.Z * CapsuleHalfHeight);
 
-			AStrategyChar* const MinionChar =  GetWorld()->SpawnActor<AStrategyChar>(Owner->MinionCharClass, Loc, Owner->GetActorRotation(), SpawnInfo);
+			// and spawn our minion, or wake up one from the pool
+			AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+			AStrategyChar* MinionChar = nullptr;
+			if (GameState != nullptr && GameState->GetMinionPool() != nullptr)
+			{
+				MinionChar = GameState->GetMinionPool()->AcquireMinion(MinionClass, Loc, Owner->GetActorRotation());
+			}
+			else
+			{
+				FActorSpawnParameters SpawnInfo;
+				SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+				MinionChar = GetWorld()->SpawnActor<AStrategyChar>(MinionClass, Loc, Owner->GetActorRotation(), SpawnInfo);
+			}
 			// don't continue if he died right away on spawn
 			if ( (MinionChar != nullptr) && (MinionChar->bIsDying == false) )
 			{
@@ -177,33 +501,62 @@ void UStrategyAIDirector::SpawnMinions()
 				MinionChar->SetTeamNum(GetTeamNum());
 
 				MinionChar->SpawnDefaultController();
+
+				//同一波的怪物组成一个小队，第一个生成的做队长
+				AStrategyAIController* const MinionController = Cast<AStrategyAIController>(MinionChar->GetController());
+				if (MinionController != nullptr)
+				{
+					if (!CurrentSquad.IsValid())
+					{
+						CurrentSquad = MakeShareable(new FStrategySquad());
+					}
+					MinionController->SetSquad(CurrentSquad);
+				}
 				MinionChar->GetCapsuleComponent()->SetRelativeScale3D(Scale);
 				MinionChar->GetCapsuleComponent()->SetCapsuleSize(CapsuleRadius, CapsuleHalfHeight);
 				MinionChar->GetMesh()->GlobalAnimRateScale = AnimationRate;
 
-				AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
 				if (GameState != nullptr)
 				{
 					GameState->OnCharSpawned(MinionChar);
 				}
 
+				// pooled minions may carry attachments this wave doesn't get
+				if (WeaponClass == nullptr)
+				{
+					MinionChar->SetWeaponAttachment(nullptr);
+				}
+				if (ArmorClass == nullptr)
+				{
+					MinionChar->SetArmorAttachment(nullptr);
+				}
+
 				MinionChar->ApplyBuff(BuffModifier);
-				if (DefaultWeapon != nullptr)
+				if (WeaponClass != nullptr)
 				{
-					UStrategyGameBlueprintLibrary::GiveWeaponFromClass(MinionChar, DefaultWeapon);
+					UStrategyGameBlueprintLibrary::GiveWeaponFromClass(MinionChar, WeaponClass);
 				}
-				if (DefaultArmor != nullptr)
+				if (ArmorClass != nullptr)
 				{
-					UStrategyGameBlueprintLibrary::GiveArmorFromClass(MinionChar, DefaultArmor);
+					UStrategyGameBlueprintLibrary::GiveArmorFromClass(MinionChar, ArmorClass);
 				}
 
 				WaveSize -= 1;
 				WaveSize = FMath::Max(WaveSize, 0);
+				if (WaveSize <= 0)
+				{
+					// wave is complete, next one gets a squad of its own
+					CurrentSquad.Reset();
+				}
 				if (Owner != nullptr && WaveSize <= 0 && MyTeamNum==EStrategyTeam::Enemy)
 				{
 					Owner->OnWaveSpawned.Broadcast();
 				}
-				NextSpawnTime = GetWorld()->GetTimeSeconds() + FMath::FRandRange(2.0f, 3.0f);
+				NextSpawnTime = GetWorld()->GetTimeSeconds() + SpawnRandomStream.FRandRange(2.0f, 3.0f);
+				if (WaveSize <= 0 && CurrentPlanWave != INDEX_NONE)
+				{
+					StartPlannedWave(CurrentPlanWave + 1);
+				}
 			}
 			else
 			{
@@ -223,13 +576,51 @@ void UStrategyAIDirector::SpawnMinions()
 	}
 }
 
+void UStrategyAIDirector::UpdateEnemyBrewery()
+{
+	if (EnemyBrewery == nullptr)
+	{
+		const EStrategyTeam::Type EnemyTeamNum = (MyTeamNum == EStrategyTeam::Player ? EStrategyTeam::Enemy : EStrategyTeam::Player);
+		const FPlayerData* const EnemyTeamData = GetWorld()->GetGameState<AStrategyGameState>()->GetPlayerData(EnemyTeamNum);
+		if (EnemyTeamData != nullptr && EnemyTeamData->Brewery != nullptr)
+		{
+			EnemyBrewery = EnemyTeamData->Brewery;
+			GetWorld()->GetGameState<AStrategyGameState>()->NotifyBreweryChanged();
+		}
+	}
+}
+
 void UStrategyAIDirector::RequestSpawn()
 {
 	WaveSize += 1;
+
+	// wake up, there is something to spawn now
+	ScheduleSpawn();
+}
+
+void UStrategyAIDirector::SetWaveSize(int32 InWaveSize)
+{
+	WaveSize = FMath::Max(InWaveSize, 0);
+	ScheduleSpawn();
 }
 
-void UStrategyAIDirector::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+void UStrategyAIDirector::OnSpawnTimer()
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 	SpawnMinions();
+	ScheduleSpawn();
+}
+
+void UStrategyAIDirector::ScheduleSpawn()
+{
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (!IsActive() || bLoadingSpawnClasses || WaveSize <= 0)
+	{
+		// classes still loading will schedule spawn once they are in,
+		// RequestSpawn, SetWaveSize or next planned wave wake us up when there is something to spawn
+		TimerManager.ClearTimer(TimerHandle_SpawnMinions);
+		return;
+	}
+
+	const float Delay = FMath::Max(NextSpawnTime - GetWorld()->GetTimeSeconds(), 0.01f);
+	TimerManager.SetTimer(TimerHandle_SpawnMinions, this, &UStrategyAIDirector::OnSpawnTimer, Delay, false);
 }
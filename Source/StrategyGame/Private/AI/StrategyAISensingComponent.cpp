@@ -2,6 +2,8 @@
 
 #include "StrategyGame.h"
 #include "StrategyAISensingComponent.h"
+#include "StrategyTeamInterface.h"
+#include "StrategyAISensingManager.h"
 
 UStrategyAISensingComponent::UStrategyAISensingComponent(const FObjectInitializer& ObjectInitializer) 
 	: Super(ObjectInitializer)
@@ -12,6 +14,10 @@ UStrategyAISensingComponent::UStrategyAISensingComponent(const FObjectInitialize
 	bOnlySensePlayers = false;
 	bHearNoises = false;
 	bSeePawns = true;
+	// updates are driven by UStrategyAISensingManager instead of our own timer
+	bEnableSensingUpdates = false;
+	LastSensingTime = 0.0f;
+	TargetForgetTime = 2.0f;
 }
 
 void UStrategyAISensingComponent::InitializeComponent()
@@ -19,6 +25,23 @@ void UStrategyAISensingComponent::InitializeComponent()
 	Super::InitializeComponent();
 	// set custom data from config file
 	SightRadius = SightDistance;
+
+	AStrategyGameState* const GameState = GetWorld() ? GetWorld()->GetGameState<AStrategyGameState>() : nullptr;
+	if (GameState != nullptr && GameState->GetSensingManager() != nullptr)
+	{
+		GameState->GetSensingManager()->RegisterSensor(this);
+	}
+}
+
+void UStrategyAISensingComponent::UninitializeComponent()
+{
+	AStrategyGameState* const GameState = GetWorld() ? GetWorld()->GetGameState<AStrategyGameState>() : nullptr;
+	if (GameState != nullptr && GameState->GetSensingManager() != nullptr)
+	{
+		GameState->GetSensingManager()->UnregisterSensor(this);
+	}
+
+	Super::UninitializeComponent();
 }
 
 //检查的条件：AStrategyChar，可见的，存活的，敌对的
@@ -33,36 +56,142 @@ bool UStrategyAISensingComponent::CanSenseAnything() const
 	return SightRadius > 0.0f;
 }
 
-void UStrategyAISensingComponent::UpdateAISensing()
+bool UStrategyAISensingComponent::MakeSensingQuery(FStrategySensingQuery& OutQuery) const
 {
 	const AActor* const Owner = GetOwner();
 	if (!IsValid(Owner) || (Owner->GetWorld() == NULL))
 	{
 		// Cannot sense without a valid owner in the world.
-		return;
+		return false;
 	}
 
-	//遍历世界中所有的pawn
-	for (FConstPawnIterator Iterator = Owner->GetWorld()->GetPawnIterator(); Iterator; ++Iterator)
+	const IStrategyTeamInterface* const OwnerTeam = Cast<const IStrategyTeamInterface>(Owner);
+	if (OwnerTeam == nullptr || OwnerTeam->GetTeamNum() == EStrategyTeam::Unknown)
+	{
+		// nobody is our enemy
+		return false;
+	}
+
+	OutQuery.SensorLocation = GetSensorLocation();
+	OutQuery.SensorDirection = GetSensorRotation().Vector();
+	OutQuery.SightRadius = SightRadius;
+	OutQuery.PeripheralVisionCosine = GetPeripheralVisionCosine();
+	OutQuery.TeamNum = OwnerTeam->GetTeamNum();
+	OutQuery.RandomStream.Initialize(FMath::Rand());
+	return true;
+}
+
+void UStrategyAISensingComponent::GatherVisibleUnits(const FStrategyUnitGrid& UnitGrid, FStrategySensingQuery& Query, TArray<int32>& OutUnits)
+{
+	//只查询视野范围内格子里的敌对角色
+	TArray<int32> NearbyUnits;
+	for (uint8 TeamNum = EStrategyTeam::Unknown + 1; TeamNum < EStrategyTeam::MAX; TeamNum++)
 	{
-		AStrategyChar* const TestChar = Cast<AStrategyChar>(*Iterator);
-		//不是自己，并且是可见属性的
-		if (!IsSensorActor(TestChar) && ShouldCheckVisibilityOf(TestChar))
+		if (TeamNum != Query.TeamNum)
 		{
-			//检查距离和角度
-			if (CouldSeePawn(TestChar, true))
-			{
-				KnownTargets.AddUnique(TestChar);
-			}
+			UnitGrid.GatherUnits(Query.SensorLocation, Query.SightRadius, TeamNum, NearbyUnits);
 		}
 	}
 
-	for (int32 i = KnownTargets.Num() - 1; i >= 0; i--)
+	const FStrategyUnitSnapshot& Snapshot = UnitGrid.GetSnapshot();
+	const float SightRadiusSquared = FMath::Square(Query.SightRadius);
+	for (int32 Idx = 0; Idx < NearbyUnits.Num(); Idx++)
 	{
-		const AStrategyChar* TestChar = Cast<AStrategyChar>(KnownTargets[i].Get());
-		if (TestChar == NULL)
+		//存活的，可见的
+		const int32 UnitIdx = NearbyUnits[Idx];
+		if (Snapshot.Healths[UnitIdx] <= 0 || Snapshot.HiddenFlags[UnitIdx] != 0)
+		{
+			continue;
+		}
+
+		//检查距离和角度，与UPawnSensingComponent::CouldSeePawn一致
+		const FVector SelfToOther = Snapshot.Locations[UnitIdx] - Query.SensorLocation;
+		const float SelfToOtherDistSquared = SelfToOther.SizeSquared();
+		if (SelfToOtherDistSquared > SightRadiusSquared)
+		{
+			continue;
+		}
+
+		// may skip if more than some fraction of maxdist away (longer time to acquire)
+		if (FMath::Square(Query.RandomStream.FRand()) * SelfToOtherDistSquared > FMath::Square(0.4f * Query.SightRadius))
 		{
-			KnownTargets.RemoveAt(i);
+			continue;
 		}
+
+		if ((SelfToOther.GetSafeNormal() | Query.SensorDirection) >= Query.PeripheralVisionCosine)
+		{
+			OutUnits.Add(UnitIdx);
+		}
+	}
+}
+
+void UStrategyAISensingComponent::MergeSensedUnits(const FStrategyUnitGrid& UnitGrid, const TArray<int32>& SensedUnits)
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const FStrategyUnitSnapshot& Snapshot = UnitGrid.GetSnapshot();
+
+	TArray<AActor*> SensedTargets;
+	for (int32 Idx = 0; Idx < SensedUnits.Num(); Idx++)
+	{
+		AStrategyChar* const SensedChar = Snapshot.Chars[SensedUnits[Idx]];
+		if (IsSensorActor(SensedChar))
+		{
+			continue;
+		}
+
+		//记录最后一次看见的时间
+		float* LastSeenTime = KnownTargets.Find(SensedChar);
+		if (LastSeenTime != nullptr)
+		{
+			*LastSeenTime = CurrentTime;
+		}
+		else
+		{
+			KnownTargets.Add(SensedChar, CurrentTime);
+			SensedTargets.Add(SensedChar);
+		}
+	}
+
+	//移除已经死亡的目标，以及一段时间没有看见的目标（离开视野或者被挡住）
+	TArray<AActor*> LostTargets;
+	for (auto It = KnownTargets.CreateIterator(); It; ++It)
+	{
+		const AStrategyChar* TestChar = Cast<AStrategyChar>(It.Key().Get());
+		const bool bIsDead = TestChar == nullptr || TestChar->GetHealth() <= 0 || TestChar->bHidden;
+		// last seen time is only refreshed by line of sight confirmed sightings, so this covers targets behind walls too
+		const bool bIsForgotten = !bIsDead && CurrentTime - It.Value() > TargetForgetTime;
+		if (bIsDead || bIsForgotten)
+		{
+			LostTargets.Add(It.Key().Get());
+			It.RemoveCurrent();
+		}
+	}
+
+	// notify once the set is consistent again
+	for (int32 Idx = 0; Idx < SensedTargets.Num(); Idx++)
+	{
+		OnTargetSensed.Broadcast(SensedTargets[Idx]);
+	}
+	for (int32 Idx = 0; Idx < LostTargets.Num(); Idx++)
+	{
+		OnTargetLost.Broadcast(LostTargets[Idx]);
+	}
+}
+
+void UStrategyAISensingComponent::UpdateAISensing()
+{
+	AStrategyGameState* const GameState = GetWorld() ? GetWorld()->GetGameState<AStrategyGameState>() : nullptr;
+	FStrategySensingQuery Query;
+	if (GameState == nullptr || !MakeSensingQuery(Query))
+	{
+		return;
+	}
+
+	TArray<int32> SensedUnits;
+	GatherVisibleUnits(GameState->GetUnitGrid(), Query, SensedUnits);
+	if (GameState->GetSensingManager() != nullptr)
+	{
+		GameState->GetSensingManager()->FilterByLineOfSight(GameState->GetUnitGrid(), Query.SensorLocation, SensedUnits);
 	}
+	MergeSensedUnits(GameState->GetUnitGrid(), SensedUnits);
 }
@@ -0,0 +1,228 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAISensingManager.h"
+#include "StrategyAISensingComponent.h"
+#include "ParallelFor.h"
+
+UStrategyAISensingManager::UStrategyAISensingManager(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, MaxSensingTimePerFrame(1.0f)
+	, LineOfSightCacheTTL(0.5f)
+	, MaxLineOfSightTracesPerFrame(64)
+	, NextSensorIndex(0)
+	, AverageSensorTime(0.00002)
+	, NextLineOfSightTraceId(0)
+	, LastLineOfSightPruneTime(0.0f)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+
+	LineOfSightTraceDelegate.BindUObject(this, &UStrategyAISensingManager::OnLineOfSightTraceDone);
+}
+
+void UStrategyAISensingManager::RegisterSensor(UStrategyAISensingComponent* Sensor)
+{
+	if (Sensor != nullptr)
+	{
+		Sensors.AddUnique(Sensor);
+	}
+}
+
+void UStrategyAISensingManager::UnregisterSensor(UStrategyAISensingComponent* Sensor)
+{
+	const int32 Idx = Sensors.Find(Sensor);
+	if (Idx != INDEX_NONE)
+	{
+		Sensors.RemoveAtSwap(Idx);
+	}
+}
+
+void UStrategyAISensingManager::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AStrategyGameState* const GameState = Cast<AStrategyGameState>(GetOwner());
+	if (GameState == nullptr)
+	{
+		return;
+	}
+
+	// one shared snapshot of all units for every sensor updated this frame
+	FStrategyUnitGrid& UnitGrid = GameState->GetUnitGrid();
+	UnitGrid.RefreshUnits();
+
+	// how many sensors fit in our budget, judging by previous frames
+	const double MaxSensingTime = MaxSensingTimePerFrame / 1000.0;
+	const int32 MaxDueSensors = FMath::Max(1, FMath::FloorToInt(MaxSensingTime / FMath::Max(AverageSensorTime, 0.0000001)));
+
+	//从上一帧停下的位置开始轮询，收集需要更新的感官组件
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const int32 NumSensors = Sensors.Num();
+	DueSensors.Reset();
+	DueQueries.Reset();
+	for (int32 Count = 0; Count < NumSensors && DueSensors.Num() < MaxDueSensors; Count++)
+	{
+		if (NextSensorIndex >= Sensors.Num())
+		{
+			NextSensorIndex = 0;
+		}
+
+		UStrategyAISensingComponent* const Sensor = Sensors[NextSensorIndex++];
+		if (Sensor == nullptr || !Sensor->CanSenseAnything() || CurrentTime - Sensor->LastSensingTime < Sensor->SensingInterval)
+		{
+			continue;
+		}
+
+		Sensor->LastSensingTime = CurrentTime;
+
+		FStrategySensingQuery Query;
+		if (Sensor->MakeSensingQuery(Query))
+		{
+			DueSensors.Add(Sensor);
+			DueQueries.Add(Query);
+		}
+	}
+
+	const int32 NumDueSensors = DueSensors.Num();
+	if (NumDueSensors == 0)
+	{
+		IssueLineOfSightTraces();
+		PruneLineOfSightCache(CurrentTime);
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// sight checks only read the snapshot, so they can run on all cores
+	SensedUnits.SetNum(NumDueSensors);
+	ParallelFor(NumDueSensors, [&](int32 Idx)
+	{
+		SensedUnits[Idx].Reset();
+		UStrategyAISensingComponent::GatherVisibleUnits(UnitGrid, DueQueries[Idx], SensedUnits[Idx]);
+	});
+
+	// merging touches UObjects, back on game thread
+	for (int32 Idx = 0; Idx < NumDueSensors; Idx++)
+	{
+		FilterByLineOfSight(UnitGrid, DueQueries[Idx].SensorLocation, SensedUnits[Idx]);
+		DueSensors[Idx]->MergeSensedUnits(UnitGrid, SensedUnits[Idx]);
+	}
+
+	const double SensorTime = (FPlatformTime::Seconds() - StartTime) / NumDueSensors;
+	AverageSensorTime = FMath::Lerp(AverageSensorTime, SensorTime, 0.1);
+
+	IssueLineOfSightTraces();
+	PruneLineOfSightCache(CurrentTime);
+}
+
+void UStrategyAISensingManager::FilterByLineOfSight(const FStrategyUnitGrid& UnitGrid, const FVector& SensorLocation, TArray<int32>& InOutUnits)
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	const FStrategyUnitSnapshot& Snapshot = UnitGrid.GetSnapshot();
+	const FIntPoint ObserverCell = UnitGrid.GetCell(SensorLocation);
+
+	for (int32 Idx = InOutUnits.Num() - 1; Idx >= 0; Idx--)
+	{
+		const int32 UnitIdx = InOutUnits[Idx];
+		const FStrategyLineOfSightKey Key(ObserverCell, Snapshot.Cells[UnitIdx]);
+
+		FStrategyLineOfSightEntry* Entry = LineOfSightCache.Find(Key);
+		if (Entry == nullptr)
+		{
+			Entry = &LineOfSightCache.Add(Key, FStrategyLineOfSightEntry());
+			Entry->ResultTime = CurrentTime - LineOfSightCacheTTL;
+		}
+
+		//结果过期了就重新检测，检测完成前继续使用上一次的结果
+		if (!Entry->bTracePending && CurrentTime - Entry->ResultTime >= LineOfSightCacheTTL)
+		{
+			Entry->bTracePending = true;
+			Entry->RequestTime = CurrentTime;
+			LineOfSightRequests.Add(FStrategyLineOfSightRequest(Key, SensorLocation, Snapshot.Locations[UnitIdx]));
+		}
+
+		if (!Entry->bVisible)
+		{
+			InOutUnits.RemoveAtSwap(Idx);
+		}
+	}
+}
+
+void UStrategyAISensingManager::IssueLineOfSightTraces()
+{
+	if (LineOfSightRequests.Num() == 0)
+	{
+		return;
+	}
+
+	// pawns never block sight, only level geometry does
+	static const FName LineOfSightTraceTag(TEXT("SensingLineOfSight"));
+	const FCollisionQueryParams TraceParams(LineOfSightTraceTag, false);
+	FCollisionResponseParams ResponseParams;
+	ResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+
+	const int32 NumTraces = FMath::Min(LineOfSightRequests.Num(), MaxLineOfSightTracesPerFrame);
+	for (int32 Idx = 0; Idx < NumTraces; Idx++)
+	{
+		const FStrategyLineOfSightRequest& Request = LineOfSightRequests[Idx];
+		const uint32 TraceId = NextLineOfSightTraceId++;
+		LineOfSightTraces.Add(TraceId, Request.Key);
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Test, Request.Start, Request.End, ECC_Visibility, TraceParams, ResponseParams, &LineOfSightTraceDelegate, TraceId);
+	}
+
+	// whatever did not fit will be requested again next time it's needed
+	for (int32 Idx = NumTraces; Idx < LineOfSightRequests.Num(); Idx++)
+	{
+		FStrategyLineOfSightEntry* Entry = LineOfSightCache.Find(LineOfSightRequests[Idx].Key);
+		if (Entry != nullptr)
+		{
+			Entry->bTracePending = false;
+		}
+	}
+
+	LineOfSightRequests.Reset();
+}
+
+void UStrategyAISensingManager::OnLineOfSightTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	FStrategyLineOfSightKey Key(FIntPoint::ZeroValue, FIntPoint::ZeroValue);
+	if (!LineOfSightTraces.RemoveAndCopyValue(TraceDatum.UserData, Key))
+	{
+		return;
+	}
+
+	FStrategyLineOfSightEntry* Entry = LineOfSightCache.Find(Key);
+	if (Entry != nullptr)
+	{
+		bool bBlocked = false;
+		for (int32 Idx = 0; Idx < TraceDatum.OutHits.Num(); Idx++)
+		{
+			bBlocked |= TraceDatum.OutHits[Idx].bBlockingHit;
+		}
+
+		Entry->bVisible = !bBlocked;
+		Entry->bTracePending = false;
+		Entry->ResultTime = GetWorld()->GetTimeSeconds();
+	}
+}
+
+void UStrategyAISensingManager::PruneLineOfSightCache(float CurrentTime)
+{
+	if (CurrentTime - LastLineOfSightPruneTime < LineOfSightCacheTTL * 4.0f)
+	{
+		return;
+	}
+
+	LastLineOfSightPruneTime = CurrentTime;
+	for (auto It = LineOfSightCache.CreateIterator(); It; ++It)
+	{
+		const FStrategyLineOfSightEntry& Entry = It.Value();
+		const bool bTraceLost = Entry.bTracePending && CurrentTime - Entry.RequestTime > LineOfSightCacheTTL * 4.0f;
+		const bool bUnused = !Entry.bTracePending && CurrentTime - Entry.ResultTime > LineOfSightCacheTTL * 4.0f;
+		if (bTraceLost || bUnused)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,203 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyAITargetingManager.h"
+#include "StrategyAIController.h"
+#include "StrategyAISensingComponent.h"
+
+/** Possible assignment of attacker to target */
+struct FStrategyTargetCandidate
+{
+	/** index of attacker */
+	int32 AttackerIdx;
+
+	/** index of target */
+	int32 TargetIdx;
+
+	/** cost of the assignment, lower is better */
+	float Cost;
+
+	bool operator<(const FStrategyTargetCandidate& Other) const
+	{
+		return Cost < Other.Cost;
+	}
+};
+
+UStrategyAITargetingManager::UStrategyAITargetingManager(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, TargetingInterval(0.5f)
+	, MaxAttackersPerTarget(3)
+	, AttackerCostDistance(900.0f)
+	, CurrentTargetBonusDistance(300.0f)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	bWantsBeginPlay = true;
+
+	for (int32 Idx = 0; Idx < EStrategyTeam::MAX; Idx++)
+	{
+		LastSolveTime[Idx] = 0.0f;
+	}
+}
+
+void UStrategyAITargetingManager::RegisterController(AStrategyAIController* Controller)
+{
+	if (Controller != nullptr)
+	{
+		Controllers.AddUnique(Controller);
+	}
+}
+
+void UStrategyAITargetingManager::UnregisterController(AStrategyAIController* Controller)
+{
+	const int32 Idx = Controllers.Find(Controller);
+	if (Idx != INDEX_NONE)
+	{
+		Controllers.RemoveAtSwap(Idx);
+	}
+}
+
+void UStrategyAITargetingManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//各阵营错开分配时间，避免在同一帧内全部计算
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	for (int32 Idx = 0; Idx < EStrategyTeam::MAX; Idx++)
+	{
+		LastSolveTime[Idx] = CurrentTime - TargetingInterval * Idx / EStrategyTeam::MAX;
+	}
+}
+
+void UStrategyAITargetingManager::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//按固定频率重新分配，单位移动后目标的远近也会变化
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	for (uint8 TeamNum = 0; TeamNum < EStrategyTeam::MAX; TeamNum++)
+	{
+		if (TeamNum != EStrategyTeam::Unknown && CurrentTime - LastSolveTime[TeamNum] >= TargetingInterval)
+		{
+			// keep team's place in the interval, unless it fell behind by more than a whole interval
+			LastSolveTime[TeamNum] = FMath::Max(LastSolveTime[TeamNum] + TargetingInterval, CurrentTime - TargetingInterval);
+			SolveTeam(TeamNum);
+
+			// at most one team per frame, others wait for their turn
+			break;
+		}
+	}
+}
+
+void UStrategyAITargetingManager::SolveTeam(uint8 TeamNum)
+{
+	// collect attackers and union of their known targets
+	TArray<AStrategyAIController*> Attackers;
+	TArray<AActor*> Targets;
+	TMap<AActor*, int32> TargetIndices;
+	TArray<FStrategyTargetCandidate> Candidates;
+
+	const float CurrentTargetBonus = FMath::Square(CurrentTargetBonusDistance);
+	for (int32 ControllerIdx = 0; ControllerIdx < Controllers.Num(); ControllerIdx++)
+	{
+		AStrategyAIController* const Controller = Controllers[ControllerIdx];
+		const APawn* const MyPawn = Controller != nullptr ? Controller->GetPawn() : nullptr;
+		if (MyPawn == nullptr || !Controller->IsLogicEnabled() || Controller->GetTeamNum() != TeamNum)
+		{
+			continue;
+		}
+
+		const int32 AttackerIdx = Attackers.Add(Controller);
+		const FVector PawnLocation = MyPawn->GetActorLocation();
+
+		for (auto It = Controller->GetSensingComponent()->KnownTargets.CreateConstIterator(); It; ++It)
+		{
+			AActor* const TestTarget = It.Key().Get();
+			if (TestTarget == nullptr || !Controller->IsTargetValid(TestTarget))
+			{
+				continue;
+			}
+
+			/** don't care about targets with disabled logic */
+			const APawn* TestPawn = Cast<APawn>(TestTarget);
+			const AStrategyAIController* AITarget = (TestPawn ? Cast<AStrategyAIController>(TestPawn->Controller) : nullptr);
+			if (AITarget != nullptr && !AITarget->IsLogicEnabled())
+			{
+				continue;
+			}
+
+			int32* TargetIdx = TargetIndices.Find(TestTarget);
+			if (TargetIdx == nullptr)
+			{
+				TargetIdx = &TargetIndices.Add(TestTarget, Targets.Add(TestTarget));
+			}
+
+			FStrategyTargetCandidate Candidate;
+			Candidate.AttackerIdx = AttackerIdx;
+			Candidate.TargetIdx = *TargetIdx;
+			Candidate.Cost = (PawnLocation - TestTarget->GetActorLocation()).SizeSquared();
+			if (Controller->CurrentTarget == TestTarget)
+			{
+				Candidate.Cost -= CurrentTargetBonus;
+			}
+			Candidates.Add(Candidate);
+		}
+	}
+
+	if (Attackers.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<AActor*> Assignments;
+	Assignments.SetNumZeroed(Attackers.Num());
+	TArray<int32> AttackerCounts;
+	AttackerCounts.SetNumZeroed(Targets.Num());
+
+	//按代价从小到大贪心分配，每个目标最多分配MaxAttackersPerTarget个攻击者
+	TArray<FStrategyTargetCandidate> SortedCandidates = Candidates;
+	SortedCandidates.Sort();
+	int32 NumAssigned = 0;
+	for (int32 Idx = 0; Idx < SortedCandidates.Num() && NumAssigned < Attackers.Num(); Idx++)
+	{
+		const FStrategyTargetCandidate& Candidate = SortedCandidates[Idx];
+		if (Assignments[Candidate.AttackerIdx] == nullptr && AttackerCounts[Candidate.TargetIdx] < MaxAttackersPerTarget)
+		{
+			Assignments[Candidate.AttackerIdx] = Targets[Candidate.TargetIdx];
+			AttackerCounts[Candidate.TargetIdx]++;
+			NumAssigned++;
+		}
+	}
+
+	// all targets in reach are full, pick cheapest one counting attackers already there
+	// candidates are still grouped by attacker in the unsorted array
+	const float AttackerCost = FMath::Square(AttackerCostDistance);
+	for (int32 Idx = 0; Idx < Candidates.Num() && NumAssigned < Attackers.Num(); )
+	{
+		const int32 AttackerIdx = Candidates[Idx].AttackerIdx;
+		int32 BestTargetIdx = INDEX_NONE;
+		float BestCost = 0.0f;
+		for (; Idx < Candidates.Num() && Candidates[Idx].AttackerIdx == AttackerIdx; Idx++)
+		{
+			const FStrategyTargetCandidate& Candidate = Candidates[Idx];
+			const float Cost = Candidate.Cost + AttackerCounts[Candidate.TargetIdx] * AttackerCost;
+			if (BestTargetIdx == INDEX_NONE || Cost < BestCost)
+			{
+				BestTargetIdx = Candidate.TargetIdx;
+				BestCost = Cost;
+			}
+		}
+
+		if (Assignments[AttackerIdx] == nullptr && BestTargetIdx != INDEX_NONE)
+		{
+			Assignments[AttackerIdx] = Targets[BestTargetIdx];
+			AttackerCounts[BestTargetIdx]++;
+			NumAssigned++;
+		}
+	}
+
+	for (int32 AttackerIdx = 0; AttackerIdx < Attackers.Num(); AttackerIdx++)
+	{
+		Attackers[AttackerIdx]->SetCurrentTarget(Assignments[AttackerIdx]);
+	}
+}
@@ -0,0 +1,353 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyFlowField.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "AI/Navigation/NavMeshBoundsVolume.h"
+
+namespace StrategyFlowField
+{
+	/** direction of cells without a way to the goal */
+	const uint8 NoDirection = 0xFF;
+
+	/** direction of goal cells */
+	const uint8 GoalDirection = 0xFE;
+
+	/** maximum number of cells in a single field */
+	const int32 MaxCells = 256 * 256;
+
+	/** offsets of neighbor cells, orthogonal ones first */
+	const int32 NeighborX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int32 NeighborY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	/** index of neighbor in opposite direction */
+	const uint8 Opposite[8] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+
+	/** cost of moving to orthogonal and diagonal neighbor */
+	const float StepCost = 1.0f;
+	const float DiagonalStepCost = 1.41421356f;
+
+	/** number of cells processed between two checks of the time budget */
+	const int32 CellsPerTimeCheck = 32;
+}
+
+FStrategyFlowField::FStrategyFlowField()
+	: CellSize(200.0f)
+	, Origin(FVector2D::ZeroVector)
+	, SizeX(0)
+	, SizeY(0)
+	, GoalLocation(FVector::ZeroVector)
+	, BuildStep(BuildIdle)
+	, NextBuildCell(0)
+	, ProjectExtent(FVector::ZeroVector)
+	, ProjectCenterZ(0.0f)
+{
+}
+
+void FStrategyFlowField::Reset()
+{
+	SizeX = 0;
+	SizeY = 0;
+	Heights.Reset();
+	Links.Reset();
+	Costs.Reset();
+	Directions.Reset();
+	OpenList.Reset();
+	BuildStep = BuildIdle;
+	NextBuildCell = 0;
+}
+
+bool FStrategyFlowField::IsBuilding() const
+{
+	return BuildStep != BuildIdle;
+}
+
+bool FStrategyFlowField::IsValid() const
+{
+	return BuildStep == BuildIdle && Directions.Num() > 0;
+}
+
+float FStrategyFlowField::GetCellSize() const
+{
+	return CellSize;
+}
+
+const FVector& FStrategyFlowField::GetGoalLocation() const
+{
+	return GoalLocation;
+}
+
+void FStrategyFlowField::StartBuild(UWorld* World, const FVector& InGoalLocation, float InCellSize)
+{
+	using namespace StrategyFlowField;
+
+	Reset();
+	GoalLocation = InGoalLocation;
+	CellSize = FMath::Max(InCellSize, 10.0f);
+
+	if (World == nullptr || World->GetNavigationSystem() == nullptr)
+	{
+		return;
+	}
+
+	// navigable area is what nav mesh bounds volumes cover
+	FBox Bounds(0);
+	for (TActorIterator<ANavMeshBoundsVolume> It(World); It; ++It)
+	{
+		Bounds += It->GetComponentsBoundingBox();
+	}
+	if (!Bounds.IsValid)
+	{
+		return;
+	}
+
+	SizeX = FMath::CeilToInt((Bounds.Max.X - Bounds.Min.X) / CellSize);
+	SizeY = FMath::CeilToInt((Bounds.Max.Y - Bounds.Min.Y) / CellSize);
+	if (SizeX * SizeY > MaxCells)
+	{
+		// keep memory and build time bounded for huge levels
+		CellSize *= FMath::Sqrt(float(SizeX * SizeY) / MaxCells);
+		SizeX = FMath::CeilToInt((Bounds.Max.X - Bounds.Min.X) / CellSize);
+		SizeY = FMath::CeilToInt((Bounds.Max.Y - Bounds.Min.Y) / CellSize);
+	}
+	Origin = FVector2D(Bounds.Min.X, Bounds.Min.Y);
+	ProjectExtent = FVector(CellSize * 0.5f, CellSize * 0.5f, Bounds.Max.Z - Bounds.Min.Z);
+	ProjectCenterZ = (Bounds.Max.Z + Bounds.Min.Z) * 0.5f;
+
+	Heights.SetNumUninitialized(SizeX * SizeY);
+	BuildStep = BuildSampling;
+}
+
+bool FStrategyFlowField::UpdateBuild(UWorld* World, double EndTime)
+{
+	using namespace StrategyFlowField;
+
+	UNavigationSystem* const NavSys = World != nullptr ? World->GetNavigationSystem() : nullptr;
+	if (BuildStep == BuildIdle || NavSys == nullptr)
+	{
+		if (BuildStep != BuildIdle)
+		{
+			Reset();
+		}
+		return true;
+	}
+
+	//每处理一批格子检查一次时间，超出预算就留到下一次继续
+	const int32 NumCells = SizeX * SizeY;
+	int32 NumProcessed = 0;
+	auto IsOutOfTime = [&]()
+	{
+		return (++NumProcessed % CellsPerTimeCheck) == 0 && FPlatformTime::Seconds() >= EndTime;
+	};
+
+	if (BuildStep == BuildSampling)
+	{
+		for (; NextBuildCell < NumCells; NextBuildCell++)
+		{
+			if (IsOutOfTime())
+			{
+				return false;
+			}
+			SampleCell(NavSys, NextBuildCell);
+		}
+
+		Links.Init(0, NumCells);
+		NextBuildCell = 0;
+		BuildStep = BuildLinking;
+	}
+
+	if (BuildStep == BuildLinking)
+	{
+		for (; NextBuildCell < NumCells; NextBuildCell++)
+		{
+			if (IsOutOfTime())
+			{
+				return false;
+			}
+			LinkCell(World, NextBuildCell);
+		}
+
+		Costs.Init(MAX_FLT, NumCells);
+		Directions.Init(NoDirection, NumCells);
+		SeedGoal();
+		BuildStep = BuildIntegrating;
+	}
+
+	if (BuildStep == BuildIntegrating)
+	{
+		while (OpenList.Num() > 0)
+		{
+			if (IsOutOfTime())
+			{
+				return false;
+			}
+
+			FOpenNode Node(INDEX_NONE, 0.0f);
+			OpenList.HeapPop(Node, false);
+			IntegrateNode(Node);
+		}
+
+		BuildStep = BuildIdle;
+		if (!Directions.Contains(GoalDirection))
+		{
+			Reset();
+		}
+	}
+
+	return true;
+}
+
+void FStrategyFlowField::SampleCell(UNavigationSystem* NavSys, int32 Index)
+{
+	//把格子的中心投影到导航网格上，投影失败的格子不可通行
+	const FVector CellCenter(Origin.X + (Index % SizeX + 0.5f) * CellSize, Origin.Y + (Index / SizeX + 0.5f) * CellSize, ProjectCenterZ);
+	FNavLocation NavLocation;
+	Heights[Index] = NavSys->ProjectPointToNavigation(CellCenter, NavLocation, ProjectExtent) ? NavLocation.Location.Z : MAX_FLT;
+}
+
+void FStrategyFlowField::LinkCell(UWorld* World, int32 Index)
+{
+	using namespace StrategyFlowField;
+
+	if (Heights[Index] == MAX_FLT)
+	{
+		return;
+	}
+
+	// cells on both sides of a thin wall or cliff both project but must not be connected
+	// every pair is tested once, from the cell with lower index
+	const float MaxStepHeight = CellSize;
+	const int32 ForwardDirs[] = { 0, 2, 4, 5 };
+	const FVector CellLocation = GetCellLocation(Index);
+	for (int32 DirIdx = 0; DirIdx < ARRAY_COUNT(ForwardDirs); DirIdx++)
+	{
+		const int32 Dir = ForwardDirs[DirIdx];
+		const int32 X = Index % SizeX + NeighborX[Dir];
+		const int32 Y = Index / SizeX + NeighborY[Dir];
+		if (X < 0 || Y < 0 || X >= SizeX || Y >= SizeY)
+		{
+			continue;
+		}
+
+		const int32 NeighborIndex = Y * SizeX + X;
+		if (Heights[NeighborIndex] == MAX_FLT || FMath::Abs(Heights[NeighborIndex] - Heights[Index]) > MaxStepHeight)
+		{
+			continue;
+		}
+
+		FVector HitLocation;
+		if (!UNavigationSystem::NavigationRaycast(World, CellLocation, GetCellLocation(NeighborIndex), HitLocation))
+		{
+			Links[Index] |= 1 << Dir;
+			Links[NeighborIndex] |= 1 << Opposite[Dir];
+		}
+	}
+}
+
+void FStrategyFlowField::SeedGoal()
+{
+	using namespace StrategyFlowField;
+
+	// seed with walkable cells around the goal, the goal itself usually stands on blocked area
+	const int32 GoalX = FMath::FloorToInt((GoalLocation.X - Origin.X) / CellSize);
+	const int32 GoalY = FMath::FloorToInt((GoalLocation.Y - Origin.Y) / CellSize);
+	for (int32 Radius = 0; Radius < 8 && OpenList.Num() == 0; Radius++)
+	{
+		for (int32 Y = GoalY - Radius; Y <= GoalY + Radius; Y++)
+		{
+			for (int32 X = GoalX - Radius; X <= GoalX + Radius; X++)
+			{
+				if (X < 0 || Y < 0 || X >= SizeX || Y >= SizeY || Heights[Y * SizeX + X] == MAX_FLT)
+				{
+					continue;
+				}
+
+				const int32 Index = Y * SizeX + X;
+				Costs[Index] = FVector::Dist2D(GetCellLocation(Index), GoalLocation) / CellSize;
+				Directions[Index] = GoalDirection;
+				OpenList.HeapPush(FOpenNode(Index, Costs[Index]));
+			}
+		}
+	}
+}
+
+void FStrategyFlowField::IntegrateNode(const FOpenNode& Node)
+{
+	using namespace StrategyFlowField;
+
+	if (Node.Cost > Costs[Node.Index])
+	{
+		return;
+	}
+
+	const int32 NodeX = Node.Index % SizeX;
+	const int32 NodeY = Node.Index / SizeX;
+	for (int32 Dir = 0; Dir < 8; Dir++)
+	{
+		if ((Links[Node.Index] & (1 << Dir)) == 0)
+		{
+			continue;
+		}
+
+		const int32 X = NodeX + NeighborX[Dir];
+		const int32 Y = NodeY + NeighborY[Dir];
+		const int32 Index = Y * SizeX + X;
+
+		// no corner cutting
+		if (Dir >= 4 && (Heights[NodeY * SizeX + X] == MAX_FLT || Heights[Y * SizeX + NodeX] == MAX_FLT))
+		{
+			continue;
+		}
+
+		const float NewCost = Node.Cost + (Dir >= 4 ? DiagonalStepCost : StepCost);
+		if (NewCost < Costs[Index])
+		{
+			Costs[Index] = NewCost;
+			// neighbor walks back the same way we came
+			Directions[Index] = Opposite[Dir];
+			OpenList.HeapPush(FOpenNode(Index, NewCost));
+		}
+	}
+}
+
+int32 FStrategyFlowField::GetCellIndex(const FVector& Location) const
+{
+	const int32 X = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - Origin.Y) / CellSize);
+	return (X >= 0 && Y >= 0 && X < SizeX && Y < SizeY) ? Y * SizeX + X : INDEX_NONE;
+}
+
+FVector FStrategyFlowField::GetCellLocation(int32 Index) const
+{
+	const int32 X = Index % SizeX;
+	const int32 Y = Index / SizeX;
+	return FVector(Origin.X + (X + 0.5f) * CellSize, Origin.Y + (Y + 0.5f) * CellSize, Heights[Index]);
+}
+
+bool FStrategyFlowField::GetWaypoint(const FVector& FromLocation, int32 MaxSteps, FVector& OutWaypoint) const
+{
+	using namespace StrategyFlowField;
+
+	const int32 StartIndex = GetCellIndex(FromLocation);
+	if (StartIndex == INDEX_NONE || Directions[StartIndex] == NoDirection || Directions[StartIndex] == GoalDirection)
+	{
+		return false;
+	}
+
+	//沿着流场方向一直走，直到方向改变
+	const uint8 StartDirection = Directions[StartIndex];
+	int32 Index = StartIndex;
+	for (int32 Step = 0; Step < MaxSteps; Step++)
+	{
+		const uint8 Dir = Directions[Index];
+		if (Dir == GoalDirection || (Step > 0 && Dir != StartDirection))
+		{
+			break;
+		}
+
+		Index = (Index / SizeX + NeighborY[Dir]) * SizeX + (Index % SizeX + NeighborX[Dir]);
+	}
+
+	OutWaypoint = GetCellLocation(Index);
+	return true;
+}
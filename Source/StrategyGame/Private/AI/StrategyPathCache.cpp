@@ -0,0 +1,174 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyPathCache.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "AI/Navigation/NavigationData.h"
+#include "AI/Navigation/RecastNavMesh.h"
+
+FStrategyPathCache::FStrategyPathCache()
+	: CellSize(200.0f)
+	, TTL(0.5f)
+	, LastPruneTime(0.0f)
+	, NumHits(0)
+	, NumMisses(0)
+	, NumCoalesced(0)
+{
+}
+
+void FStrategyPathCache::Configure(float InCellSize, float InTTL, const FNavPathQueryDelegate& InOnQueryFinished)
+{
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	TTL = InTTL;
+	OnQueryFinished = InOnQueryFinished;
+	Paths.Reset();
+
+	// results of queries in flight are ignored from now on, don't leave their waiters hanging
+	TArray<FPendingPath> DroppedPaths;
+	PendingPaths.GenerateValueArray(DroppedPaths);
+	PendingPaths.Reset();
+	PendingQueries.Reset();
+	for (int32 PathIdx = 0; PathIdx < DroppedPaths.Num(); PathIdx++)
+	{
+		for (int32 Idx = 0; Idx < DroppedPaths[PathIdx].Waiters.Num(); Idx++)
+		{
+			DroppedPaths[PathIdx].Waiters[Idx].ExecuteIfBound(nullptr);
+		}
+	}
+}
+
+int32 FStrategyPathCache::GetNumHits() const
+{
+	return NumHits;
+}
+
+int32 FStrategyPathCache::GetNumMisses() const
+{
+	return NumMisses;
+}
+
+int32 FStrategyPathCache::GetNumCoalesced() const
+{
+	return NumCoalesced;
+}
+
+FIntPoint FStrategyPathCache::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void FStrategyPathCache::RequestPath(AAIController* Controller, AActor* GoalActor, const FVector& GoalLocation, const FOnStrategyPathFound& OnPathFound)
+{
+	const APawn* const MyPawn = Controller != nullptr ? Controller->GetPawn() : nullptr;
+	UWorld* const World = Controller != nullptr ? Controller->GetWorld() : nullptr;
+	if (MyPawn == nullptr || World == nullptr)
+	{
+		OnPathFound.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	const float CurrentTime = World->GetTimeSeconds();
+	Prune(CurrentTime);
+
+	const FVector StartLocation = MyPawn->GetNavAgentLocation();
+	const FVector EndLocation = GoalActor != nullptr ? GoalActor->GetActorLocation() : GoalLocation;
+	const FPathKey Key(GetCell(StartLocation), GoalActor != nullptr ? FIntPoint::ZeroValue : GetCell(GoalLocation), GoalActor);
+
+	//缓存里有还没过期的路径，直接复制一份；刚刚寻路失败的目标直接返回失败
+	const FPathEntry* Entry = Paths.Find(Key);
+	if (Entry != nullptr && CurrentTime - Entry->Time < TTL)
+	{
+		NumHits++;
+		OnPathFound.ExecuteIfBound(Entry->Path.IsValid() ? CopyPath(Entry->Path, GoalActor) : nullptr);
+		return;
+	}
+
+	//同样的请求正在计算中，等待它的结果
+	FPendingPath* Pending = PendingPaths.Find(Key);
+	if (Pending != nullptr)
+	{
+		NumCoalesced++;
+		Pending->Waiters.Add(OnPathFound);
+		return;
+	}
+
+	UNavigationSystem* const NavSys = World->GetNavigationSystem();
+	const ANavigationData* const NavData = NavSys != nullptr ? NavSys->GetNavDataForProps(Controller->GetNavAgentPropertiesRef()) : nullptr;
+	if (NavData == nullptr || !OnQueryFinished.IsBound())
+	{
+		OnPathFound.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	NumMisses++;
+
+	FPathFindingQuery Query(Controller, *NavData, StartLocation, EndLocation, NavData->GetDefaultQueryFilter());
+	const uint32 QueryId = NavSys->FindPathAsync(Controller->GetNavAgentPropertiesRef(), Query, OnQueryFinished);
+
+	FPendingPath& NewPending = PendingPaths.Add(Key);
+	NewPending.QueryId = QueryId;
+	NewPending.GoalActor = GoalActor;
+	NewPending.Waiters.Add(OnPathFound);
+	PendingQueries.Add(QueryId, Key);
+}
+
+void FStrategyPathCache::OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path, float CurrentTime)
+{
+	FPathKey Key;
+	if (!PendingQueries.RemoveAndCopyValue(QueryId, Key))
+	{
+		return;
+	}
+
+	FPendingPath Pending;
+	if (!PendingPaths.RemoveAndCopyValue(Key, Pending))
+	{
+		return;
+	}
+
+	// failures are cached too, so a crowd doesn't keep querying a goal it can't reach
+	const bool bSuccess = Result == ENavigationQueryResult::Success && Path.IsValid();
+	if (bSuccess || Result == ENavigationQueryResult::Fail)
+	{
+		FPathEntry& NewEntry = Paths.Add(Key);
+		NewEntry.Path = bSuccess ? Path : nullptr;
+		NewEntry.Time = CurrentTime;
+	}
+
+	AActor* const GoalActor = Pending.GoalActor.Get();
+	for (int32 Idx = 0; Idx < Pending.Waiters.Num(); Idx++)
+	{
+		Pending.Waiters[Idx].ExecuteIfBound(bSuccess ? CopyPath(Path, GoalActor) : nullptr);
+	}
+}
+
+FNavPathSharedPtr FStrategyPathCache::CopyPath(const FNavPathSharedPtr& Path, AActor* GoalActor)
+{
+	// path following updates the path it follows, so every agent gets its own
+	FNavPathSharedPtr NewPath = MakeShareable(new FNavMeshPath());
+	NewPath->GetPathPoints() = Path->GetPathPoints();
+	NewPath->SetNavigationDataUsed(Path->GetNavigationDataUsed());
+	NewPath->MarkReady();
+	if (GoalActor != nullptr)
+	{
+		NewPath->SetGoalActorObservation(*GoalActor, 100.0f);
+	}
+	return NewPath;
+}
+
+void FStrategyPathCache::Prune(float CurrentTime)
+{
+	if (CurrentTime - LastPruneTime < TTL * 4.0f)
+	{
+		return;
+	}
+
+	LastPruneTime = CurrentTime;
+	for (auto It = Paths.CreateIterator(); It; ++It)
+	{
+		if (CurrentTime - It.Value().Time >= TTL)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
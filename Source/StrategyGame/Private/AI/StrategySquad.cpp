@@ -0,0 +1,84 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategySquad.h"
+#include "StrategyAIController.h"
+
+FStrategySquad::FStrategySquad()
+	: FormationSpacing(120.0f)
+	, FormationRowSize(3)
+{
+}
+
+void FStrategySquad::AddMember(AStrategyAIController* Member)
+{
+	if (Member != nullptr && FindMember(Member) == INDEX_NONE)
+	{
+		Members.Add(Member);
+	}
+}
+
+void FStrategySquad::RemoveMember(AStrategyAIController* Member)
+{
+	const int32 Idx = FindMember(Member);
+	if (Idx != INDEX_NONE)
+	{
+		// keep order, it decides who leads next and formation slots
+		Members.RemoveAt(Idx);
+	}
+}
+
+int32 FStrategySquad::FindMember(const AStrategyAIController* Member) const
+{
+	for (int32 Idx = 0; Idx < Members.Num(); Idx++)
+	{
+		if (Members[Idx].Get() == Member)
+		{
+			return Idx;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+AStrategyAIController* FStrategySquad::GetLeader() const
+{
+	for (int32 Idx = 0; Idx < Members.Num(); Idx++)
+	{
+		AStrategyAIController* const Member = Members[Idx].Get();
+		const AStrategyChar* const MemberChar = Member != nullptr ? Cast<AStrategyChar>(Member->GetPawn()) : nullptr;
+		if (MemberChar != nullptr && MemberChar->GetHealth() > 0 && Member->IsLogicEnabled())
+		{
+			return Member;
+		}
+	}
+
+	return nullptr;
+}
+
+bool FStrategySquad::GetFormationLocation(const AStrategyAIController* Member, FVector& OutLocation) const
+{
+	const AStrategyAIController* const Leader = GetLeader();
+	if (Leader == nullptr || Leader == Member)
+	{
+		return false;
+	}
+
+	// slot among followers, leader comes first
+	const int32 LeaderIdx = FindMember(Leader);
+	const int32 MemberIdx = FindMember(Member);
+	if (MemberIdx == INDEX_NONE)
+	{
+		return false;
+	}
+	const int32 SlotIdx = MemberIdx > LeaderIdx ? MemberIdx - 1 : MemberIdx;
+
+	//队员排在队长身后，每排FormationRowSize个
+	const int32 Row = SlotIdx / FormationRowSize + 1;
+	const int32 Column = SlotIdx % FormationRowSize;
+	const FVector LocalOffset(-Row * FormationSpacing, (Column - (FormationRowSize - 1) * 0.5f) * FormationSpacing, 0.0f);
+
+	const APawn* const LeaderPawn = Leader->GetPawn();
+	OutLocation = LeaderPawn->GetActorLocation() + FRotator(0.0f, LeaderPawn->GetActorRotation().Yaw, 0.0f).RotateVector(LocalOffset);
+	return true;
+}
@@ -0,0 +1,204 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyUnitGrid.h"
+
+FStrategyUnitGrid::FStrategyUnitGrid()
+	: CellSize(500.0f)
+{
+}
+
+void FStrategyUnitGrid::SetCellSize(float InCellSize)
+{
+	InCellSize = FMath::Max(InCellSize, 1.0f);
+	if (InCellSize == CellSize)
+	{
+		return;
+	}
+
+	CellSize = InCellSize;
+
+	// re-bucket everything we already know about
+	for (int32 Idx = 0; Idx < EStrategyTeam::MAX; Idx++)
+	{
+		Cells[Idx].Reset();
+	}
+
+	for (int32 Idx = 0; Idx < Snapshot.Num(); Idx++)
+	{
+		Snapshot.Cells[Idx] = GetCell(Snapshot.Locations[Idx]);
+		Cells[Snapshot.TeamNums[Idx]].FindOrAdd(Snapshot.Cells[Idx]).Add(Idx);
+	}
+}
+
+float FStrategyUnitGrid::GetCellSize() const
+{
+	return CellSize;
+}
+
+FIntPoint FStrategyUnitGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+int32 FStrategyUnitGrid::GetNumUnits() const
+{
+	return Snapshot.Num();
+}
+
+const FStrategyUnitSnapshot& FStrategyUnitGrid::GetSnapshot() const
+{
+	return Snapshot;
+}
+
+void FStrategyUnitGrid::AddUnit(AStrategyChar* InChar)
+{
+	if (InChar == nullptr || UnitIndices.Contains(InChar))
+	{
+		return;
+	}
+
+	const FVector Location = InChar->GetActorLocation();
+	const uint8 TeamNum = InChar->GetTeamNum() < EStrategyTeam::MAX ? InChar->GetTeamNum() : EStrategyTeam::Unknown;
+
+	const int32 Index = Snapshot.Chars.Add(InChar);
+	Snapshot.Locations.Add(Location);
+	Snapshot.Cells.Add(GetCell(Location));
+	Snapshot.Healths.Add(InChar->GetHealth());
+	Snapshot.TeamNums.Add(TeamNum);
+	Snapshot.HiddenFlags.Add(InChar->bHidden ? 1 : 0);
+
+	UnitIndices.Add(InChar, Index);
+	Cells[TeamNum].FindOrAdd(Snapshot.Cells[Index]).Add(Index);
+}
+
+void FStrategyUnitGrid::RemoveUnit(AStrategyChar* InChar)
+{
+	const int32* IndexPtr = UnitIndices.Find(InChar);
+	if (IndexPtr == nullptr)
+	{
+		return;
+	}
+
+	const int32 Index = *IndexPtr;
+	const int32 LastIndex = Snapshot.Num() - 1;
+	RemoveFromCell(Index);
+	UnitIndices.Remove(InChar);
+
+	//把最后一个单位挪到空出来的位置上，并修正它在格子里的索引
+	if (Index != LastIndex)
+	{
+		TArray<int32>& CellUnits = Cells[Snapshot.TeamNums[LastIndex]].FindChecked(Snapshot.Cells[LastIndex]);
+		CellUnits[CellUnits.Find(LastIndex)] = Index;
+		UnitIndices.FindChecked(Snapshot.Chars[LastIndex]) = Index;
+	}
+
+	Snapshot.Chars.RemoveAtSwap(Index);
+	Snapshot.Locations.RemoveAtSwap(Index);
+	Snapshot.Cells.RemoveAtSwap(Index);
+	Snapshot.Healths.RemoveAtSwap(Index);
+	Snapshot.TeamNums.RemoveAtSwap(Index);
+	Snapshot.HiddenFlags.RemoveAtSwap(Index);
+}
+
+void FStrategyUnitGrid::UpdateUnit(AStrategyChar* InChar)
+{
+	const int32* IndexPtr = UnitIndices.Find(InChar);
+	if (IndexPtr != nullptr)
+	{
+		RefreshUnit(*IndexPtr);
+	}
+}
+
+void FStrategyUnitGrid::RefreshUnits()
+{
+	for (int32 Idx = 0; Idx < Snapshot.Num(); Idx++)
+	{
+		RefreshUnit(Idx);
+	}
+}
+
+void FStrategyUnitGrid::RefreshUnit(int32 Index)
+{
+	const AStrategyChar* const MyChar = Snapshot.Chars[Index];
+
+	Snapshot.Locations[Index] = MyChar->GetActorLocation();
+	Snapshot.Healths[Index] = MyChar->GetHealth();
+	Snapshot.HiddenFlags[Index] = MyChar->bHidden ? 1 : 0;
+
+	const FIntPoint NewCell = GetCell(Snapshot.Locations[Index]);
+	const uint8 NewTeamNum = MyChar->GetTeamNum() < EStrategyTeam::MAX ? MyChar->GetTeamNum() : EStrategyTeam::Unknown;
+
+	//还在原来的格子里，无需更新
+	if (NewCell == Snapshot.Cells[Index] && NewTeamNum == Snapshot.TeamNums[Index])
+	{
+		return;
+	}
+
+	RemoveFromCell(Index);
+	Snapshot.Cells[Index] = NewCell;
+	Snapshot.TeamNums[Index] = NewTeamNum;
+	Cells[NewTeamNum].FindOrAdd(NewCell).Add(Index);
+}
+
+void FStrategyUnitGrid::RemoveFromCell(int32 Index)
+{
+	const uint8 TeamNum = Snapshot.TeamNums[Index];
+	TArray<int32>* CellUnits = Cells[TeamNum].Find(Snapshot.Cells[Index]);
+	if (CellUnits != nullptr)
+	{
+		CellUnits->RemoveSingleSwap(Index);
+		if (CellUnits->Num() == 0)
+		{
+			Cells[TeamNum].Remove(Snapshot.Cells[Index]);
+		}
+	}
+}
+
+void FStrategyUnitGrid::GatherUnits(const FVector& Center, float Radius, uint8 TeamNum, TArray<int32>& OutUnits) const
+{
+	if (TeamNum >= EStrategyTeam::MAX || Cells[TeamNum].Num() == 0)
+	{
+		return;
+	}
+
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius, Radius, 0.0f));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius, Radius, 0.0f));
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<int32>* CellUnits = Cells[TeamNum].Find(FIntPoint(X, Y));
+			if (CellUnits != nullptr)
+			{
+				OutUnits.Append(*CellUnits);
+			}
+		}
+	}
+}
+
+float FStrategyUnitGrid::GetNearestEnemyDistSquared(const FVector& Location, float Radius, uint8 TeamNum) const
+{
+	TArray<int32> NearbyUnits;
+	for (uint8 TestTeamNum = EStrategyTeam::Unknown + 1; TestTeamNum < EStrategyTeam::MAX; TestTeamNum++)
+	{
+		if (TestTeamNum != TeamNum)
+		{
+			GatherUnits(Location, Radius, TestTeamNum, NearbyUnits);
+		}
+	}
+
+	float BestDistSq = MAX_FLT;
+	const float RadiusSq = FMath::Square(Radius);
+	for (int32 Idx = 0; Idx < NearbyUnits.Num(); Idx++)
+	{
+		const int32 UnitIdx = NearbyUnits[Idx];
+		const float DistSq = (Snapshot.Locations[UnitIdx] - Location).SizeSquared2D();
+		if (Snapshot.Healths[UnitIdx] > 0 && DistSq <= RadiusSq && DistSq < BestDistSq)
+		{
+			BestDistSq = DistSq;
+		}
+	}
+
+	return BestDistSq;
+}
@@ -0,0 +1,11 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyWaveSchedule.h"
+
+UStrategyWaveSchedule::UStrategyWaveSchedule(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, bLoop(false)
+	, RandomSeed(0)
+{
+}
@@ -55,6 +55,12 @@ void AStrategyBuilding_Brewery::PostInitializeComponents()
 		MyData->ResourcesAvailable = ResourceInitial;
 		MyData->Brewery = this;
 	}
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState != nullptr)
+	{
+		GameState->NotifyBreweryChanged();
+	}
 }
 
 void AStrategyBuilding_Brewery::OnGameplayStateChange(EGameplayState::Type NewState)
@@ -9,9 +9,9 @@ UStrategyAnimInstance::UStrategyAnimInstance(const FObjectInitializer& ObjectIni
 
 void UStrategyAnimInstance::AnimNotify_Melee(UAnimNotify* Notify)
 {
-	// notify the pawn of the impact
+	// notify the pawn of the impact, dying pawns don't hit anymore
 	AStrategyChar* const MyChar = Cast<AStrategyChar>(TryGetPawnOwner());
-	if (MyChar)
+	if (MyChar && !MyChar->bIsDying && MyChar->GetHealth() > 0)
 	{
 		MyChar->OnMeleeImpactNotify();
 	}
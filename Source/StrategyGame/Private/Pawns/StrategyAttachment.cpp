@@ -7,3 +7,35 @@ UStrategyAttachment::UStrategyAttachment(const FObjectInitializer& ObjectInitial
 {
 	Effect.bInfiniteDuration = true;
 }
+
+void UStrategyAttachment::AttachToBody(USkeletalMeshComponent* BodyMesh)
+{
+	check(BodyMesh);
+
+	const bool bSharesSkeleton = SkeletalMesh != nullptr && BodyMesh->SkeletalMesh != nullptr && SkeletalMesh->Skeleton == BodyMesh->SkeletalMesh->Skeleton;
+	if (bSharesSkeleton)
+	{
+		// skinned to body, copy its bones instead of running our own update
+		AttachTo(BodyMesh);
+		SetMasterPoseComponent(BodyMesh);
+	}
+	else
+	{
+		AttachTo(BodyMesh, AttachPoint);
+
+		//插槽上的刚体道具没有动画时，骨骼永远是参考姿势，不需要每帧更新
+		if (GetAnimInstance() == nullptr)
+		{
+			SetComponentTickEnabled(false);
+		}
+	}
+}
+
+void UStrategyAttachment::DetachFromBody()
+{
+	if (MasterPoseComponent.IsValid())
+	{
+		SetMasterPoseComponent(nullptr);
+	}
+	DetachFromParent();
+}
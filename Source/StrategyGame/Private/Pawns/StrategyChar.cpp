@@ -3,10 +3,15 @@
 #include "StrategyGame.h"
 #include "StrategyAIController.h"
 #include "StrategyAttachment.h"
+#include "StrategyMinionMovementComponent.h"
+#include "StrategyMinionPool.h"
 
 AStrategyChar::AStrategyChar(const FObjectInitializer& ObjectInitializer) 
-	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCharacterMovementComponent>(ACharacter::CharacterMovementComponentName)) 
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UStrategyMinionMovementComponent>(ACharacter::CharacterMovementComponentName)) 
 	, ResourcesToGather(10)
+	, MeshUpdateFlag(EMeshComponentUpdateFlag::AlwaysTickPose)
+	, bMeshUpdateRateOptimizations(true)
+	, PooledController(nullptr)
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -31,11 +36,118 @@ void AStrategyChar::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
+	// animation update settings of this minion class
+	GetMesh()->MeshComponentUpdateFlag = MeshUpdateFlag;
+	GetMesh()->bEnableUpdateRateOptimizations = bMeshUpdateRateOptimizations;
+
 	// initialization
 	UpdatePawnData();
 	UpdateHealth();
 }
 
+void AStrategyChar::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState)
+	{
+		GameState->GetUnitGrid().AddUnit(this);
+	}
+}
+
+void AStrategyChar::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState)
+	{
+		GameState->GetUnitGrid().RemoveUnit(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AStrategyChar::SpawnDefaultController()
+{
+	if (Controller == nullptr && PooledController != nullptr && !PooledController->IsPendingKill())
+	{
+		AStrategyAIController* const AIController = PooledController;
+		PooledController = nullptr;
+		AIController->Possess(this);
+		return;
+	}
+
+	Super::SpawnDefaultController();
+}
+
+void AStrategyChar::SleepInPool()
+{
+	if (Controller != nullptr)
+	{
+		PooledController = Cast<AStrategyAIController>(Controller);
+		Controller->UnPossess();
+	}
+
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState)
+	{
+		GameState->GetUnitGrid().RemoveUnit(this);
+	}
+
+	if (GetCharacterMovement())
+	{
+		GetCharacterMovement()->StopMovementImmediately();
+		GetCharacterMovement()->DisableMovement();
+		GetCharacterMovement()->SetComponentTickEnabled(false);
+	}
+	GetMesh()->SetComponentTickEnabled(false);
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+}
+
+void AStrategyChar::WakeFromPool(const FVector& Location, const FRotator& Rotation)
+{
+	const AStrategyChar* const DefaultChar = GetClass()->GetDefaultObject<AStrategyChar>();
+
+	bIsDying = false;
+	Health = DefaultChar->Health;
+	ActiveBuffs.Reset();
+	MyTeamNum = EStrategyTeam::Unknown;
+
+	SetActorLocationAndRotation(Location, Rotation);
+
+	//恢复死亡时关闭的碰撞
+	if (GetCapsuleComponent())
+	{
+		GetCapsuleComponent()->SetCollisionEnabled(DefaultChar->GetCapsuleComponent()->GetCollisionEnabled());
+		GetCapsuleComponent()->SetCollisionResponseToChannels(DefaultChar->GetCapsuleComponent()->GetCollisionResponseToChannels());
+	}
+
+	if (GetCharacterMovement())
+	{
+		GetCharacterMovement()->SetComponentTickEnabled(true);
+	}
+	GetMesh()->SetComponentTickEnabled(true);
+	StopAnimMontage();
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState)
+	{
+		GameState->GetUnitGrid().AddUnit(this);
+	}
+
+	UpdatePawnData();
+	UpdateHealth();
+}
+
 bool AStrategyChar::CanBeBaseForCharacter(APawn* Pawn) const
 {
 	return false;
@@ -168,13 +280,16 @@ void AStrategyChar::Die(float KillingDamage, FDamageEvent const& DamageEvent, AC
 	GetWorldTimerManager().ClearAllTimersForObject(this);
 
 	// notify the game mode if an Enemy dies
-	if (GetTeamNum() == EStrategyTeam::Enemy)
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState && GetTeamNum() == EStrategyTeam::Enemy)
 	{
-		AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
-		if (GameState)
-		{
-			GameState->OnCharDied(this);
-		}
+		GameState->OnCharDied(this);
+	}
+
+	// dead units are of no interest to proximity queries
+	if (GameState)
+	{
+		GameState->GetUnitGrid().RemoveUnit(this);
 	}
 
 	// disable any AI
@@ -199,9 +314,10 @@ void AStrategyChar::Die(float KillingDamage, FDamageEvent const& DamageEvent, AC
 		GetCharacterMovement()->DisableMovement();
 	}
 
-	// detach the controller
+	// detach the controller, keep it for reuse from minion pool
 	if (Controller != nullptr)
 	{
+		PooledController = AIController;
 		Controller->UnPossess();
 	}	
 
@@ -221,6 +337,21 @@ void AStrategyChar::Die(float KillingDamage, FDamageEvent const& DamageEvent, AC
 void AStrategyChar::OnDieAnimationEnd()
 {
 	this->SetActorHiddenInGame(true);
+
+	//放回对象池，等待下一次生成时使用
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState && GameState->GetMinionPool() && GameState->GetMinionPool()->ReleaseMinion(this))
+	{
+		return;
+	}
+
+	// no room in pool, controller goes with us
+	if (PooledController != nullptr)
+	{
+		PooledController->Destroy();
+		PooledController = nullptr;
+	}
+
 	// delete the pawn asap
 	SetLifeSpan( 0.01f );
 }
@@ -232,7 +363,8 @@ void AStrategyChar::SetWeaponAttachment(UStrategyAttachment* Weapon)
 		// detach any existing weapon attachment
 		if (WeaponSlot )
 		{
-			WeaponSlot->DetachFromParent();
+			WeaponSlot->DetachFromBody();
+			WeaponSlot->DestroyComponent();
 		}
 
 		// attach this one
@@ -240,7 +372,7 @@ void AStrategyChar::SetWeaponAttachment(UStrategyAttachment* Weapon)
 		if (WeaponSlot )
 		{
 			WeaponSlot->RegisterComponent();
-			WeaponSlot->AttachTo(GetMesh(), WeaponSlot->AttachPoint);
+			WeaponSlot->AttachToBody(GetMesh());
 			UpdatePawnData();
 			UpdateHealth();
 		}
@@ -254,14 +386,15 @@ void AStrategyChar::SetArmorAttachment(UStrategyAttachment* Armor)
 		// detach any existing armor attachment
 		if (ArmorSlot )
 		{
-			ArmorSlot->DetachFromParent();
+			ArmorSlot->DetachFromBody();
+			ArmorSlot->DestroyComponent();
 		}
 		// attach this one
 		ArmorSlot = Armor;
 		if (ArmorSlot )
 		{
 			ArmorSlot->RegisterComponent();
-			ArmorSlot->AttachTo(GetMesh(), ArmorSlot->AttachPoint);
+			ArmorSlot->AttachToBody(GetMesh());
 			UpdatePawnData();
 			UpdateHealth();
 		}
@@ -286,6 +419,12 @@ uint8 AStrategyChar::GetTeamNum() const
 void AStrategyChar::SetTeamNum(uint8 NewTeamNum)
 {
 	MyTeamNum = NewTeamNum;
+
+	AStrategyGameState* const GameState = GetWorld()->GetGameState<AStrategyGameState>();
+	if (GameState)
+	{
+		GameState->GetUnitGrid().UpdateUnit(this);
+	}
 }
 
 void AStrategyChar::ApplyBuff(const FBuffData& Buff)
@@ -0,0 +1,128 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyMinionMovementComponent.h"
+
+UStrategyMinionMovementComponent::UStrategyMinionMovementComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, DynamicObstacleCheckInterval(0.25f)
+	, DynamicObstacleMargin(50.0f)
+	, MoveVelocityTTL(0.1f)
+	, DynamicObstacleCheckTimer(0.0f)
+	, bDynamicObstacleCheckPending(false)
+	, DesiredMoveVelocity(FVector::ZeroVector)
+	, AdjustedMoveVelocity(FVector::ZeroVector)
+	, DesiredMoveTime(-1.0f)
+	, AdjustedMoveTime(-1.0f)
+{
+	// spread checks and projections of units spawned together over several frames
+	DynamicObstacleCheckTimer = FMath::FRand() * DynamicObstacleCheckInterval;
+
+	// we have our own, batched avoidance
+	bUseRVOAvoidance = false;
+
+	//在导航网格上行走，只有模型高度需要定期贴合地面
+	DefaultLandMovementMode = MOVE_NavWalking;
+	bProjectNavMeshWalking = true;
+	NavMeshProjectionInterval = 0.2f;
+	NavMeshProjectionTimer = FMath::FRand() * NavMeshProjectionInterval;
+
+	DynamicObstacleCheckDelegate.BindUObject(this, &UStrategyMinionMovementComponent::OnDynamicObstacleCheckDone);
+}
+
+void UStrategyMinionMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	UpdateDynamicObstacleCheck(DeltaTime);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+void UStrategyMinionMovementComponent::UpdateDynamicObstacleCheck(float DeltaTime)
+{
+	if (PawnOwner == nullptr || UpdatedComponent == nullptr || !IsMovingOnGround() || bDynamicObstacleCheckPending)
+	{
+		return;
+	}
+
+	DynamicObstacleCheckTimer -= DeltaTime;
+	if (DynamicObstacleCheckTimer > 0.0f)
+	{
+		return;
+	}
+	DynamicObstacleCheckTimer = DynamicObstacleCheckInterval;
+
+	// only things which move around can be missing from navmesh
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+
+	static const FName DynamicObstacleTag(TEXT("MinionDynamicObstacle"));
+	const FCollisionQueryParams QueryParams(DynamicObstacleTag, false, PawnOwner);
+
+	float CapsuleRadius = 0.0f;
+	float CapsuleHalfHeight = 0.0f;
+	PawnOwner->GetSimpleCollisionCylinder(CapsuleRadius, CapsuleHalfHeight);
+	const FCollisionShape Shape = FCollisionShape::MakeSphere(CapsuleRadius + DynamicObstacleMargin);
+
+	bDynamicObstacleCheckPending = true;
+	GetWorld()->AsyncOverlapByObjectType(UpdatedComponent->GetComponentLocation(), FQuat::Identity, ObjectParams, Shape, QueryParams, &DynamicObstacleCheckDelegate);
+}
+
+void UStrategyMinionMovementComponent::OnDynamicObstacleCheckDone(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum)
+{
+	bDynamicObstacleCheckPending = false;
+
+	bool bBlocked = false;
+	for (int32 Idx = 0; Idx < OverlapDatum.OutOverlaps.Num() && !bBlocked; Idx++)
+	{
+		const UPrimitiveComponent* const OtherComp = OverlapDatum.OutOverlaps[Idx].Component.Get();
+		bBlocked = OtherComp != nullptr && OtherComp->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block;
+	}
+
+	//附近有会阻挡的动态物体时使用完整的碰撞检测，离开后回到导航网格上行走
+	if (bBlocked && MovementMode == MOVE_NavWalking)
+	{
+		SetMovementMode(MOVE_Walking);
+	}
+	else if (!bBlocked && MovementMode == MOVE_Walking)
+	{
+		SetMovementMode(MOVE_NavWalking);
+	}
+}
+
+void UStrategyMinionMovementComponent::RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed)
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	DesiredMoveVelocity = MoveVelocity;
+	DesiredMoveTime = CurrentTime;
+
+	//避让结果是上一帧根据期望速度算出来的，过期后直接使用寻路速度
+	if (CurrentTime - AdjustedMoveTime <= MoveVelocityTTL)
+	{
+		Super::RequestDirectMove(AdjustedMoveVelocity, bForceMaxSpeed);
+	}
+	else
+	{
+		Super::RequestDirectMove(MoveVelocity, bForceMaxSpeed);
+	}
+}
+
+void UStrategyMinionMovementComponent::StopActiveMovement()
+{
+	Super::StopActiveMovement();
+
+	DesiredMoveVelocity = FVector::ZeroVector;
+	AdjustedMoveTime = -1.0f;
+}
+
+FVector UStrategyMinionMovementComponent::GetDesiredMoveVelocity() const
+{
+	const bool bFresh = GetWorld()->GetTimeSeconds() - DesiredMoveTime <= MoveVelocityTTL;
+	return bFresh ? DesiredMoveVelocity : FVector::ZeroVector;
+}
+
+void UStrategyMinionMovementComponent::SetAvoidanceVelocity(const FVector& InVelocity)
+{
+	AdjustedMoveVelocity = InVelocity;
+	AdjustedMoveTime = GetWorld()->GetTimeSeconds();
+}
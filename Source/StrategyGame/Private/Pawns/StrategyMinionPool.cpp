@@ -0,0 +1,90 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "StrategyGame.h"
+#include "StrategyMinionPool.h"
+
+UStrategyMinionPool::UStrategyMinionPool(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, PrewarmCount(8)
+	, MaxPooledPerClass(32)
+{
+}
+
+void UStrategyMinionPool::Prewarm(TSubclassOf<AStrategyChar> CharClass, const FVector& Location)
+{
+	if (CharClass == nullptr || PrewarmedClasses.Contains(*CharClass))
+	{
+		return;
+	}
+	PrewarmedClasses.Add(*CharClass);
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const int32 NumToSpawn = FMath::Min(PrewarmCount, MaxPooledPerClass) - GetNumPooled(*CharClass);
+	for (int32 Idx = 0; Idx < NumToSpawn; Idx++)
+	{
+		AStrategyChar* const NewChar = GetWorld()->SpawnActor<AStrategyChar>(CharClass, Location, FRotator::ZeroRotator, SpawnInfo);
+		if (NewChar != nullptr)
+		{
+			// controller is created now as well, so first wave doesn't pay for it
+			NewChar->SpawnDefaultController();
+			ReleaseMinion(NewChar);
+		}
+	}
+}
+
+AStrategyChar* UStrategyMinionPool::AcquireMinion(TSubclassOf<AStrategyChar> CharClass, const FVector& Location, const FRotator& Rotation)
+{
+	if (CharClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (int32 Idx = PooledChars.Num() - 1; Idx >= 0; Idx--)
+	{
+		AStrategyChar* const PooledChar = PooledChars[Idx];
+		if (PooledChar == nullptr || PooledChar->IsPendingKill())
+		{
+			PooledChars.RemoveAtSwap(Idx);
+			continue;
+		}
+
+		if (PooledChar->GetClass() == *CharClass)
+		{
+			PooledChars.RemoveAtSwap(Idx);
+			PooledChar->WakeFromPool(Location, Rotation);
+			return PooledChar;
+		}
+	}
+
+	//池里没有可用的，生成一个新的
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AStrategyChar>(CharClass, Location, Rotation, SpawnInfo);
+}
+
+bool UStrategyMinionPool::ReleaseMinion(AStrategyChar* InChar)
+{
+	if (InChar == nullptr || InChar->IsPendingKill() || GetNumPooled(InChar->GetClass()) >= MaxPooledPerClass)
+	{
+		return false;
+	}
+
+	InChar->SleepInPool();
+	PooledChars.Add(InChar);
+	return true;
+}
+
+int32 UStrategyMinionPool::GetNumPooled(UClass* CharClass) const
+{
+	int32 NumPooled = 0;
+	for (int32 Idx = 0; Idx < PooledChars.Num(); Idx++)
+	{
+		if (PooledChars[Idx] != nullptr && PooledChars[Idx]->GetClass() == CharClass)
+		{
+			NumPooled++;
+		}
+	}
+	return NumPooled;
+}
@@ -95,6 +95,12 @@ void UStrategyGameBlueprintLibrary::GiveWeaponFromClass(AStrategyChar* InChar, T
 {
 	if (InChar && *ArmorClass)
 	{
+		// pooled minions keep their attachment
+		if (InChar->GetWeaponAttachment() != nullptr && InChar->GetWeaponAttachment()->GetClass() == *ArmorClass)
+		{
+			return;
+		}
+
 		auto MyWeapon = NewObject<UStrategyAttachment>(InChar, *ArmorClass);
 		InChar->SetWeaponAttachment(MyWeapon);
 	}
@@ -109,6 +115,12 @@ void UStrategyGameBlueprintLibrary::GiveArmorFromClass(AStrategyChar* InChar, TS
 {
 	if (InChar && *ArmorClass)
 	{
+		// pooled minions keep their attachment
+		if (InChar->GetArmorAttachment() != nullptr && InChar->GetArmorAttachment()->GetClass() == *ArmorClass)
+		{
+			return;
+		}
+
 		auto MyArmor = NewObject<UStrategyAttachment>(InChar, *ArmorClass);
 		InChar->SetArmorAttachment(MyArmor);
 	}
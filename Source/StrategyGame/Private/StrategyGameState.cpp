@@ -3,6 +3,12 @@
 #include "StrategyGame.h"
 #include "StrategyBuilding_Brewery.h"
 #include "StrategyTypes.h"
+#include "StrategyAISensingManager.h"
+#include "StrategyAITargetingManager.h"
+#include "StrategyAIDecisionScheduler.h"
+#include "StrategyAIAvoidanceManager.h"
+#include "StrategyMinionPool.h"
+#include "AI/Navigation/NavigationSystem.h"
 
 AStrategyGameState::AStrategyGameState(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -12,6 +18,33 @@ AStrategyGameState::AStrategyGameState(const FObjectInitializer& ObjectInitializ
 	MiniMapCamera = nullptr;
 	WinningTeam = EStrategyTeam::Unknown;
 	GameFinishedTime = 0;
+	UnitGridCellSize = 500.0f;
+	FlowFieldCellSize = 200.0f;
+	MaxFlowFieldBuildTimePerFrame = 1.0f;
+	bFlowFieldBuildScheduled = false;
+	PathCacheCellSize = 200.0f;
+	PathCacheTTL = 0.5f;
+	BreweryEpoch = 0;
+
+	SensingManager = CreateDefaultSubobject<UStrategyAISensingManager>(TEXT("SensingManager"));
+	TargetingManager = CreateDefaultSubobject<UStrategyAITargetingManager>(TEXT("TargetingManager"));
+	DecisionScheduler = CreateDefaultSubobject<UStrategyAIDecisionScheduler>(TEXT("DecisionScheduler"));
+	AvoidanceManager = CreateDefaultSubobject<UStrategyAIAvoidanceManager>(TEXT("AvoidanceManager"));
+	MinionPool = CreateDefaultSubobject<UStrategyMinionPool>(TEXT("MinionPool"));
+}
+
+void AStrategyGameState::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	// set custom data from config file
+	UnitGrid.SetCellSize(UnitGridCellSize);
+	PathCache.Configure(PathCacheCellSize, PathCacheTTL, FNavPathQueryDelegate::CreateUObject(this, &AStrategyGameState::OnPathQueryFinished));
+
+	UNavigationSystem* const NavSys = GetWorld()->GetNavigationSystem();
+	if (NavSys != nullptr)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &AStrategyGameState::OnNavigationGenerated);
+	}
 }
 
 int32 AStrategyGameState::GetNumberOfLivePawns(TEnumAsByte<EStrategyTeam::Type> InTeam) const
@@ -85,6 +118,12 @@ void AStrategyGameState::SetGameplayState(EGameplayState::Type NewState)
 		if (PlayersData[i].Brewery.IsValid())
 		{
 			PlayersData[i].Brewery->OnGameplayStateChange(NewState);
+
+			//在比赛开始前开始构建流场，单位出生时就不用等待
+			if (NewState == EGameplayState::Waiting || NewState == EGameplayState::Playing)
+			{
+				GetFlowField(PlayersData[i].Brewery.Get());
+			}
 		}
 	}
 }
@@ -169,3 +208,143 @@ float AStrategyGameState::GetGameFinishedTime() const
 {
 	return GameFinishedTime;
 }
+
+void AStrategyGameState::NotifyBreweryChanged()
+{
+	BreweryEpoch++;
+}
+
+uint32 AStrategyGameState::GetBreweryEpoch() const
+{
+	return BreweryEpoch;
+}
+
+const FStrategyFlowField* AStrategyGameState::GetFlowField(AActor* Goal)
+{
+	if (Goal == nullptr)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FStrategyFlowField>* FlowField = FlowFields.Find(Goal);
+	if (FlowField == nullptr)
+	{
+		// unreachable goals are remembered too, so they are not rebuilt on every request
+		FlowField = &FlowFields.Add(Goal, MakeShareable(new FStrategyFlowField()));
+		(*FlowField)->StartBuild(GetWorld(), Goal->GetActorLocation(), FlowFieldCellSize);
+		ScheduleFlowFieldBuilds();
+	}
+
+	// callers path find on their own until the field is ready
+	return (*FlowField)->IsValid() ? FlowField->Get() : nullptr;
+}
+
+void AStrategyGameState::OnNavigationGenerated(ANavigationData* NavData)
+{
+	for (auto It = FlowFields.CreateIterator(); It; ++It)
+	{
+		const AActor* const Goal = It.Key().Get();
+		if (Goal != nullptr)
+		{
+			It.Value()->StartBuild(GetWorld(), Goal->GetActorLocation(), FlowFieldCellSize);
+		}
+		else
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	ScheduleFlowFieldBuilds();
+}
+
+void AStrategyGameState::ScheduleFlowFieldBuilds()
+{
+	if (!bFlowFieldBuildScheduled)
+	{
+		bFlowFieldBuildScheduled = true;
+		GetWorldTimerManager().SetTimerForNextTick(this, &AStrategyGameState::UpdateFlowFieldBuilds);
+	}
+}
+
+void AStrategyGameState::UpdateFlowFieldBuilds()
+{
+	bFlowFieldBuildScheduled = false;
+
+	//每帧只花有限的时间构建流场，一个构建完再开始下一个
+	const double EndTime = FPlatformTime::Seconds() + MaxFlowFieldBuildTimePerFrame / 1000.0;
+	bool bPending = false;
+	for (auto It = FlowFields.CreateIterator(); It; ++It)
+	{
+		FStrategyFlowField& FlowField = *It.Value();
+		if (FlowField.IsBuilding() && !FlowField.UpdateBuild(GetWorld(), EndTime))
+		{
+			bPending = true;
+			break;
+		}
+	}
+
+	if (bPending)
+	{
+		ScheduleFlowFieldBuilds();
+	}
+}
+
+FStrategyPathCache& AStrategyGameState::GetPathCache()
+{
+	return PathCache;
+}
+
+const FStrategyPathCache& AStrategyGameState::GetPathCache() const
+{
+	return PathCache;
+}
+
+void AStrategyGameState::OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	PathCache.OnPathQueryFinished(QueryId, Result, Path, GetWorld()->GetTimeSeconds());
+}
+
+FStrategyUnitGrid& AStrategyGameState::GetUnitGrid()
+{
+	return UnitGrid;
+}
+
+UStrategyAISensingManager* AStrategyGameState::GetSensingManager() const
+{
+	return SensingManager;
+}
+
+FStrategyAIClaimTable& AStrategyGameState::GetClaimTable()
+{
+	return ClaimTable;
+}
+
+const FStrategyAIClaimTable& AStrategyGameState::GetClaimTable() const
+{
+	return ClaimTable;
+}
+
+UStrategyAITargetingManager* AStrategyGameState::GetTargetingManager() const
+{
+	return TargetingManager;
+}
+
+UStrategyAIDecisionScheduler* AStrategyGameState::GetDecisionScheduler() const
+{
+	return DecisionScheduler;
+}
+
+UStrategyAIAvoidanceManager* AStrategyGameState::GetAvoidanceManager() const
+{
+	return AvoidanceManager;
+}
+
+UStrategyMinionPool* AStrategyGameState::GetMinionPool() const
+{
+	return MinionPool;
+}
+
+FStreamableManager& AStrategyGameState::GetStreamableManager()
+{
+	return StreamableManager;
+}
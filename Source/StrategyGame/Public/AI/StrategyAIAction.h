@@ -6,7 +6,75 @@
 
 class AStrategyAIController;
 
+// action的激活条件所依赖的外部状态
+/** World facts ShouldActivate result depends on, cached result is dropped when one of them changes */
+namespace EStrategyAIFact
+{
+	enum Type
+	{
+		/** current target of the controller changed or became invalid */
+		CurrentTarget = 1 << 0,
+		/** own or enemy brewery changed */
+		Brewery = 1 << 1,
+		/** move finished, pawn may have arrived */
+		Arrived = 1 << 2,
+		All = 0xFF
+	};
+}
+
+// 每个AI控制器为每个action保存的状态
+/** Per agent state of a single action, owned by the controller so action objects can be shared */
+struct FStrategyAIActionState
+{
+	/** target actor to attack */
+	TWeakObjectPtr<AActor> TargetActor;
+
+	/** destination we are moving to */
+	FVector Destination;
+
+	/** intermediate point we are moving to, when following a flow field */
+	FVector Waypoint;
+
+	/** time when we will finish playing melee animation */
+	float MeleeAttackAnimationEndTime;
+
+	/** last time without movement */
+	float NotMovingFromTime;
+
+	/** tells us if action is already executed */
+	uint8 bIsExecuted : 1;
+
+	/** if pawn is playing attack animation */
+	uint8 bIsPlayingAnimation : 1;
+
+	/** set to true when we are moving to our destination */
+	uint8 bIsMoving : 1;
+
+	/** set to true when we are moving along a flow field */
+	uint8 bFollowingFlowField : 1;
+
+	/** set to true when we are keeping formation slot behind squad leader */
+	uint8 bFollowingLeader : 1;
+
+	FStrategyAIActionState()
+		: Destination(FVector::ZeroVector)
+		, Waypoint(FVector::ZeroVector)
+		, MeleeAttackAnimationEndTime(0.0f)
+		, NotMovingFromTime(0.0f)
+		, bIsExecuted(false)
+		, bIsPlayingAnimation(false)
+		, bIsMoving(false)
+		, bFollowingFlowField(false)
+		, bFollowingLeader(false)
+	{
+	}
+};
+
 // Action表示怪物的执行动作，如移动、攻击等。
+/**
+ * Actions are stateless and shared by all controllers, only the class default object is used.
+ * Everything specific to an agent lives in FStrategyAIActionState owned by its controller.
+ */
 UCLASS(abstract, BlueprintType)
 class UStrategyAIAction : public UObject
 {
@@ -16,27 +84,24 @@ class UStrategyAIAction : public UObject
 	 * Update this action.
 	 * @return false to finish this action, true to continue
 	 */
-	virtual bool Tick(float DeltaTime);
+	virtual bool Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const;
 
 	/** Activate action. */
-	virtual void Activate();
+	virtual void Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
 	/** Should we activate action this time ? */
-	virtual bool ShouldActivate() const;
+	virtual bool ShouldActivate(AStrategyAIController* Controller) const;
 
 	/** Abort action to start something else. */
-	virtual void Abort();
+	virtual void Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
 	/** Can we abort this action? */
-	virtual bool IsSafeToAbort() const;
+	virtual bool IsSafeToAbort(const FStrategyAIActionState& State) const;
 
-	/** Set owning AI controller. */
-	void SetController(AStrategyAIController* InOwner);
+	/** Get facts result of ShouldActivate depends on, see EStrategyAIFact. */
+	uint8 GetFactDependencies() const;
 
 protected:
-	/** Weak pointer to AI controller, to have faster access (cached information). */
-	TWeakObjectPtr<AStrategyAIController>	MyAIController;
-
-	/**	Tells us if we are already executed. */
-	bool bIsExecuted;
+	/** facts result of ShouldActivate depends on, see EStrategyAIFact */
+	uint8 FactDependencies;
 };
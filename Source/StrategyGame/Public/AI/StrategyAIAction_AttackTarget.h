@@ -17,47 +17,36 @@ public:
 	// Begin StrategyAIAction interface
 
 	/** Update in time current action */
-	virtual bool Tick(float DeltaTime) override;
+	virtual bool Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const override;
 
 	/** activate action */
-	virtual void Activate() override;
+	virtual void Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** abort action to start something else */
-	virtual void Abort() override;
+	virtual void Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** can we abort this action? */
-	virtual bool IsSafeToAbort() const override;
+	virtual bool IsSafeToAbort(const FStrategyAIActionState& State) const override;
 
 	/** Should we activate action this time ? */
-	virtual bool ShouldActivate() const override;
+	virtual bool ShouldActivate(AStrategyAIController* Controller) const override;
 
 	// End StrategyAIAction interface
 
 protected:
 	/** Pawn has hit something */
-	void NotifyBump(FHitResult const& Hit);
+	void NotifyBump(FHitResult const& Hit, AStrategyAIController* Controller) const;
 
 	/** notify about completing current move */
-	void OnMoveCompleted();
+	void OnMoveCompleted(AStrategyAIController* Controller) const;
 
-	/** move closer to target */
-	void MoveCloser();
+	/**
+	 * Move closer to target if it's out of attack range.
+	 *
+	 * @returns false if target is out of range and we can't get to it.
+	 */
+	bool MoveCloser(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 
 	/** updates any information about target, his location, target changes in ai controller, etc. */
-	void UpdateTargetInformation();
-
-	/** target actor to attack */
-	TWeakObjectPtr<AActor> TargetActor;
-
-	/** destination to move closer */
-	FVector	TargetDestination;
-
-	/** time when we will finish playing melee animation */
-	float MeleeAttackAnimationEndTime;
-
-	/** if pawn is playing attack animation */
-	uint32 bIsPlayingAnimation : 1;
-
-	/** set to true when we are moving to our target */
-	uint32 bMovingToTarget : 1;
+	void UpdateTargetInformation(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
 };
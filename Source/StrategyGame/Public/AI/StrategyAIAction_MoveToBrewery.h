@@ -20,38 +20,58 @@ public:
 	// Begin StrategyAIAction interface
 
 	/** Update in time current action */
-	virtual bool Tick(float DeltaTime) override;
+	virtual bool Tick(AStrategyAIController* Controller, FStrategyAIActionState& State, float DeltaTime) const override;
 
 	/** activate action */
-	virtual void Activate() override;
+	virtual void Activate(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** abort action to start something else */
-	virtual void Abort() override;
+	virtual void Abort(AStrategyAIController* Controller, FStrategyAIActionState& State) const override;
 
 	/** can we abort this action? */
-	virtual bool IsSafeToAbort() const override;
+	virtual bool IsSafeToAbort(const FStrategyAIActionState& State) const override;
 
 	/** Should we activate action this time ? */
-	virtual bool ShouldActivate() const override;
+	virtual bool ShouldActivate(AStrategyAIController* Controller) const override;
 
 	// End StrategyAIAction interface
 
 protected:
 	/** Called from owning controller when given PathGenerator updated it's path. */
-	void OnPathUpdated(INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType);
+	void OnPathUpdated(INavigationPathGenerator* PathGenerator, EPathUpdate::Type inType, AStrategyAIController* Controller) const;
 
 	/** notify about completing current move */
-	void OnMoveCompleted();
+	void OnMoveCompleted(AStrategyAIController* Controller) const;
+
+	/**
+	 * Move to next waypoint of flow field toward enemy brewery.
+	 *
+	 * @returns false if there is no flow field to follow or we reached its end.
+	 */
+	bool FollowFlowField(AStrategyAIController* Controller, FStrategyAIActionState& State, AActor* Brewery) const;
+
+	/**
+	 * Move straight to our formation slot behind squad leader, no pathfinding involved.
+	 *
+	 * @returns false if we have no leader to follow, lead ourselves or fell too far behind.
+	 */
+	bool FollowLeader(AStrategyAIController* Controller, FStrategyAIActionState& State) const;
+
+	/** Find our own way to enemy brewery, along flow field or with a path */
+	void MoveOnOwn(AStrategyAIController* Controller, FStrategyAIActionState& State, AActor* Brewery) const;
+
+	/** Get brewery we are marching to */
+	AActor* GetEnemyBrewery(AStrategyAIController* Controller) const;
 
 	/** Acceptable distance to target destination */
 	float TargetAcceptanceRadius;
 
-	/** current destination we are moving to */
-	FVector	Destination;
+	/** Maximum number of flow field cells between two waypoints */
+	int32 FlowFieldWaypointSteps;
 
-	/** tells if we stared moving to target */
-	uint8	bIsMoving : 1;
+	/** Distance formation slot has to move before we update our move to it */
+	float FormationRepathDistance;
 
-	/** last time without movement */
-	float	NotMovingFromTime;
+	/** Distance from formation slot at which we stop following leader and find our own way */
+	float MaxFormationDistance;
 };
@@ -0,0 +1,81 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyUnitGrid.h"
+#include "StrategyAIAvoidanceManager.generated.h"
+
+class UStrategyMinionMovementComponent;
+
+/**
+ * Per frame state of all units taking part in local avoidance, stored as structure of arrays.
+ * Indexing matches the unit snapshot of FStrategyUnitGrid, so grid queries can be used to find neighbours.
+ */
+struct FStrategyAvoidanceAgents
+{
+	/** movement of minions steered by avoidance, null for units only avoided by others */
+	TArray<UStrategyMinionMovementComponent*> Movements;
+
+	/** locations projected on ground plane */
+	TArray<FVector2D> Positions;
+
+	/** current velocities */
+	TArray<FVector2D> Velocities;
+
+	/** velocities requested by path following */
+	TArray<FVector2D> PreferredVelocities;
+
+	/** velocities adjusted by avoidance, written by worker threads */
+	TArray<FVector2D> NewVelocities;
+
+	/** capsule radii */
+	TArray<float> Radii;
+
+	/** maximum speeds */
+	TArray<float> MaxSpeeds;
+
+	/** set for agents steered by avoidance this frame */
+	TArray<uint8> ActiveFlags;
+
+	/** resize all arrays */
+	void SetNum(int32 NewNum);
+
+	/** get number of agents */
+	int32 Num() const { return Positions.Num(); }
+};
+
+// 局部避让管理器。每帧用ORCA算法统一计算所有怪物的避让速度。
+/**
+ * Reciprocal collision avoidance (ORCA) for all minions, solved in one batch per frame.
+ * Agent state is gathered on game thread into flat arrays, then each moving agent builds
+ * half-planes from its closest neighbours found through the unit grid and solves a small linear program on worker threads.
+ * Results are fed back to UStrategyMinionMovementComponent which moves along them instead of the raw path direction.
+ */
+UCLASS(config=Game)
+class UStrategyAIAvoidanceManager : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Radius in which neighbours are considered */
+	UPROPERTY(config)
+	float NeighbourRadius;
+
+	/** Maximum number of closest neighbours considered by a single agent */
+	UPROPERTY(config)
+	int32 MaxNeighbours;
+
+	/** Time in seconds ahead for which velocities are guaranteed collision free */
+	UPROPERTY(config)
+	float TimeHorizon;
+
+	// Begin UActorComponent Interface
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	// End UActorComponent Interface
+
+protected:
+	/** compute velocity of agent at given index, safe to call from worker threads */
+	FVector2D ComputeAvoidanceVelocity(const FStrategyUnitGrid& UnitGrid, int32 Idx, float DeltaTime) const;
+
+	/** state of all agents in current frame */
+	FStrategyAvoidanceAgents Agents;
+};
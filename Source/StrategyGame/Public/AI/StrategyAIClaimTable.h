@@ -0,0 +1,80 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+class AStrategyAIController;
+
+// 目标锁定表，记录哪些控制器把哪些控制器作为攻击目标。
+/**
+ * Registry of controllers claimed as target by other controllers.
+ * Claims are hashed by (attacker, target) pair and counted per target, so all queries are O(1).
+ * All claims made by or on a controller can be released at once when it dies or unpossesses.
+ */
+class FStrategyAIClaimTable
+{
+public:
+	/**
+	 * Record that attacker claimed target.
+	 *
+	 * @param	Attacker	Controller attacking.
+	 * @param	Target		Controller being attacked.
+	 */
+	void Claim(AStrategyAIController* Attacker, AStrategyAIController* Target);
+
+	/**
+	 * Remove claim of attacker on target.
+	 *
+	 * @param	Attacker	Controller attacking.
+	 * @param	Target		Controller being attacked.
+	 */
+	void UnClaim(AStrategyAIController* Attacker, AStrategyAIController* Target);
+
+	/**
+	 * Remove all claims made by or on controller.
+	 *
+	 * @param	Controller	Controller which is going away.
+	 */
+	void ReleaseClaims(AStrategyAIController* Controller);
+
+	/** Check if attacker claimed target. */
+	bool IsClaimedBy(const AStrategyAIController* Target, const AStrategyAIController* Attacker) const;
+
+	/** Get number of attackers who claimed target. */
+	int32 GetNumberOfAttackers(const AStrategyAIController* Target) const;
+
+protected:
+	/** single claim of attacker on target */
+	struct FClaimKey
+	{
+		const AStrategyAIController* Attacker;
+		const AStrategyAIController* Target;
+
+		FClaimKey(const AStrategyAIController* InAttacker, const AStrategyAIController* InTarget)
+			: Attacker(InAttacker)
+			, Target(InTarget)
+		{
+		}
+
+		bool operator==(const FClaimKey& Other) const
+		{
+			return Attacker == Other.Attacker && Target == Other.Target;
+		}
+
+		friend uint32 GetTypeHash(const FClaimKey& Key)
+		{
+			return HashCombine(PointerHash(Key.Attacker), PointerHash(Key.Target));
+		}
+	};
+
+	/** all claims, as (attacker, target) pairs */
+	TSet<FClaimKey> Claims;
+
+	/** number of claims on each target */
+	TMap<const AStrategyAIController*, int32> AttackerCounts;
+
+	/** targets claimed by each attacker */
+	TMultiMap<AStrategyAIController*, AStrategyAIController*> TargetsOfAttacker;
+
+	/** attackers who claimed each target */
+	TMultiMap<AStrategyAIController*, AStrategyAIController*> AttackersOfTarget;
+};
@@ -3,6 +3,8 @@
 
 #include "AIController.h"
 #include "StrategyTeamInterface.h"
+#include "StrategyAIAction.h"
+#include "StrategySquad.h"
 #include "StrategyAIController.generated.h"
 
 
@@ -18,6 +20,23 @@ namespace EPathUpdate
 	};
 }
 
+// AI的更新频率等级
+namespace EStrategyAILOD
+{
+	enum Type
+	{
+		/** enemy in melee range or we are being attacked, updated every frame */
+		Combat,
+		/** enemy close by */
+		Near,
+		/** no enemy around, but on screen */
+		Far,
+		/** no enemy around and off screen */
+		Hidden,
+		MAX
+	};
+}
+
 DECLARE_DELEGATE_OneParam(FOnBumpEvent, FHitResult const&);
 DECLARE_DELEGATE(FOnMovementEvent);
 
@@ -27,7 +46,7 @@ class UStrategyAIAction;
 class UStrategyAISensingComponent;
 
 // AI控制器，控制怪物的行为。
-UCLASS()
+UCLASS(config=Game)
 class AStrategyAIController : public AAIController, public IStrategyTeamInterface
 {
 	GENERATED_UCLASS_BODY()
@@ -43,11 +62,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=AIController)
 	TArray<TSubclassOf<UStrategyAIAction> > AllowedActions;
 
-	//可以执行的action对象列表。由AllowedActions实例化而来
-	/** List for all actions for this logic instance */
+	//可以执行的action对象列表。使用AllowedActions的默认对象，所有控制器共享
+	/** List for all actions for this logic instance, shared class default objects */
 	UPROPERTY()
 	TArray<UStrategyAIAction*> AllActions;
 
+	/** State of each action in AllActions, for this logic instance */
+	TArray<FStrategyAIActionState> ActionStates;
+
 	/** Current, selected action to execute */
 	UPROPERTY()
 	UStrategyAIAction* CurrentAction;
@@ -56,6 +78,22 @@ public:
 	UPROPERTY()
 	TArray<AActor*>	AllTargets;
 
+	/** Distance to nearest enemy below which we are in combat */
+	UPROPERTY(config)
+	float CombatLODDistance;
+
+	/** Distance to nearest enemy below which we are near an enemy */
+	UPROPERTY(config)
+	float NearLODDistance;
+
+	/** Time in seconds between tick of controller and its actions, for each LOD tier */
+	UPROPERTY(config)
+	float LODTickIntervals[EStrategyAILOD::MAX];
+
+	/** Time in seconds between two evaluations of LOD tier */
+	UPROPERTY(config)
+	float LODUpdateInterval;
+
 	//当前已经选择的攻击对象
 	/** Current selected target to attack */
 	UPROPERTY()
@@ -63,6 +101,7 @@ public:
 
 public:
 	// Begin AActor Interface
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaTime) override;
 
 #if ENABLE_VISUAL_LOG
@@ -90,6 +129,9 @@ public:
 	/** Return instance of action we are allowed to use */
 	UStrategyAIAction* GetInstanceOfAction(TSubclassOf<UStrategyAIAction> inClass) const;
 
+	/** Return our state of given action, or null if it's not one of ours */
+	FStrategyAIActionState* GetActionState(const UStrategyAIAction* Action);
+
 	/** pawn has hit something */
 	void NotifyBump(FHitResult const& Hit);
 
@@ -107,19 +149,73 @@ public:
 
 	//被InController锁定为目标
 	/** Claim controller as target */
-	void ClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController);
+	void ClaimAsTarget(AStrategyAIController* InController);
 
 	//InController取消了目标
 	/** UnClaim controller as target */
-	void UnClaimAsTarget(TWeakObjectPtr<AStrategyAIController> InController);
+	void UnClaimAsTarget(AStrategyAIController* InController);
 
 	//是否被InController锁定为目标
 	/** Check if desired controller claimed this one */
-	bool IsClaimedBy(TWeakObjectPtr<AStrategyAIController> InController) const;
+	bool IsClaimedBy(const AStrategyAIController* InController) const;
 
 	/** get number of enemies who claimed this one as target */
 	int32 GetNumberOfAttackers() const;
 
+	//设置攻击目标，由UStrategyAITargetingManager调用
+	/** Set current target and update claims, called by UStrategyAITargetingManager */
+	void SetCurrentTarget(AActor* InTarget);
+
+	/** Select best action to execute, called by UStrategyAIDecisionScheduler */
+	void UpdateDecision();
+
+	/**
+	 * Drop cached ShouldActivate results of actions depending on given facts.
+	 *
+	 * @param	Facts	Mask of changed facts, see EStrategyAIFact.
+	 */
+	void InvalidateFacts(uint8 Facts);
+
+	/** Check if we wait for UStrategyAIDecisionScheduler */
+	bool IsDecisionPending() const { return bDecisionPending; }
+
+	/** Check if we wait in high priority queue of UStrategyAIDecisionScheduler */
+	bool IsDecisionHighPriority() const { return bDecisionPending && bDecisionHighPriority; }
+
+	/** Mark if we wait for UStrategyAIDecisionScheduler, and in which queue */
+	void SetDecisionPending(bool bPending, bool bHighPriority = false) { bDecisionPending = bPending; bDecisionHighPriority = bPending && bHighPriority; }
+
+	/**
+	 * Move to actor with path found asynchronously, shared with units close by heading to the same actor.
+	 * Current move goes on until the path is found, failure is reported through OnMoveCompleted.
+	 *
+	 * @param	Goal				Actor to move to.
+	 * @param	AcceptanceRadius	Distance to goal at which we stop.
+	 */
+	void MoveToActorAsync(AActor* Goal, float AcceptanceRadius);
+
+	/**
+	 * Move to location with path found asynchronously, shared with units close by heading to the same spot.
+	 * Current move goes on until the path is found, failure is reported through OnMoveCompleted.
+	 *
+	 * @param	Dest				Location to move to.
+	 * @param	AcceptanceRadius	Distance to goal at which we stop.
+	 */
+	void MoveToLocationAsync(const FVector& Dest, float AcceptanceRadius);
+
+	/** Forget move waiting for its path, call before aborting or replacing current move. */
+	void AbortPendingMove();
+
+	/**
+	 * Join squad, leaving the previous one.
+	 *
+	 * @param	InSquad		Squad to join, null to leave current one.
+	 */
+	void SetSquad(const TSharedPtr<FStrategySquad>& InSquad);
+
+	/** Get squad we belong to, null if we are on our own */
+	FStrategySquad* GetSquad() const { return Squad.Get(); }
+
 	/** register movement related notify, to get notify about completed movement */
 	void RegisterMovementEventDelegate(FOnMovementEvent);
 	/** unregister movement related notify*/
@@ -135,24 +231,77 @@ public:
 
 
 protected:
-	/** Check targets list and select one as current target */
-	virtual void SelectTarget();
+	/** drop all claims made by or on us, stop receiving targets and decisions */
+	void ReleaseTargeting();
 
-protected:
-	//将this作为目标的controller数组
-	/** array of controllers claimed this one as target */
-	TArray< TWeakObjectPtr<AStrategyAIController> > ClaimedBy;
+	/** request path for pending move from path cache */
+	void RequestPendingMovePath();
+
+	/** path for pending move was found */
+	void OnPendingMovePathFound(FNavPathSharedPtr Path, uint32 MoveId);
+
+	/** get ShouldActivate result of action at given index, cached until one of its facts changes */
+	bool ShouldActivateAction(int32 Idx);
+
+	/** pick LOD tier from distance to nearest enemy, combat state and visibility, and apply its tick interval */
+	void UpdateLOD();
 
+protected:
 	/** Event delegate for when pawn movement is complete. */
 	FOnMovementEvent OnMoveCompletedDelegate;
 
 	/** Event delegate for when pawn has hit something. */
 	FOnBumpEvent OnNotifyBumpDelegate;
 
+	/** current LOD tier */
+	EStrategyAILOD::Type CurrentLOD;
+
+	/** time of last LOD tier evaluation */
+	float LastLODUpdateTime;
+
+	/** goal actor of move waiting for its path */
+	TWeakObjectPtr<AActor> PendingMoveGoal;
+
+	/** goal location of move waiting for its path, when not moving to actor */
+	FVector PendingMoveLocation;
+
+	/** acceptance radius of move waiting for its path */
+	float PendingMoveAcceptanceRadius;
+
+	/** id of move waiting for its path, 0 if there is none */
+	uint32 PendingMoveId;
+
+	/** id of next move */
+	uint32 NextMoveId;
+
+	/** squad we were spawned with */
+	TSharedPtr<FStrategySquad> Squad;
+
+	/** cached ShouldActivate results, one bit per action */
+	uint32 CachedActivations;
+
+	/** actions with valid cached ShouldActivate result, one bit per action */
+	uint32 ValidActivations;
+
+	/** brewery epoch of game state seen last time */
+	uint32 LastBreweryEpoch;
+
 	/** master switch state */
 	uint8 bLogicEnabled : 1;
 
+	/** set while queued in UStrategyAIDecisionScheduler */
+	uint8 bDecisionPending : 1;
+
+	/** set while queued in high priority queue of UStrategyAIDecisionScheduler */
+	uint8 bDecisionHighPriority : 1;
+
+	/** set when a cached ShouldActivate result was dropped since last decision */
+	uint8 bFactsChanged : 1;
+
 public:
+	/** Returns current LOD tier **/
+	FORCEINLINE EStrategyAILOD::Type GetCurrentLOD() const { return CurrentLOD; }
+
 	/** Returns SensingComponent subobject **/
 	FORCEINLINE UStrategyAISensingComponent* GetSensingComponent() const { return SensingComponent; }
 };
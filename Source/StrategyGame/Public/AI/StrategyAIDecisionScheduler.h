@@ -0,0 +1,63 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyAIDecisionScheduler.generated.h"
+
+class AStrategyAIController;
+
+// AI决策调度器。在每帧的时间预算内执行AI控制器的决策。
+/**
+ * Runs the decision step (action selection) of AI controllers under a per frame time budget.
+ * Controllers ask for a decision from their tick, requests are serviced in order they came in,
+ * with controllers in combat served first. A share of every frame's budget is kept for everyone else,
+ * so they are never starved by a big fight. Whatever does not fit waits for next frame.
+ */
+UCLASS(config=Game)
+class UStrategyAIDecisionScheduler : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Maximum time in milliseconds spent on AI decisions in a single frame */
+	UPROPERTY(config)
+	float MaxDecisionTimePerFrame;
+
+	/** Part of the frame budget kept for controllers out of combat */
+	UPROPERTY(config)
+	float NormalBudgetShare;
+
+	// Begin UActorComponent Interface
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	// End UActorComponent Interface
+
+	/**
+	 * Queue decision of controller. If it's already queued, it's only moved ahead when asking with high priority.
+	 *
+	 * @param	Controller		The controller asking for decision.
+	 * @param	bHighPriority	Serve before normal requests.
+	 */
+	void RequestDecision(AStrategyAIController* Controller, bool bHighPriority);
+
+	/**
+	 * Drop queued decision of controller.
+	 *
+	 * @param	Controller	The controller to forget.
+	 */
+	void CancelDecision(AStrategyAIController* Controller);
+
+protected:
+	/**
+	 * Run queued decisions until the time budget runs out.
+	 *
+	 * @returns false if budget ran out before the queue was emptied.
+	 */
+	bool ServiceQueue(TArray<AStrategyAIController*>& Queue, double EndTime);
+
+	/** controllers in combat waiting for decision */
+	UPROPERTY()
+	TArray<AStrategyAIController*> PriorityQueue;
+
+	/** other controllers waiting for decision */
+	UPROPERTY()
+	TArray<AStrategyAIController*> NormalQueue;
+};
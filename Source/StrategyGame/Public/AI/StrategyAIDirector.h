@@ -8,6 +8,47 @@
 class AStrategyBuilding_Brewery;
 class AStrategyChar;
 class UStrategyAttachment;
+class FStrategySquad;
+class ANavigationData;
+class UStrategyWaveSchedule;
+
+/** Precomputed place in front of brewery minions are spawned at */
+struct FStrategySpawnSlot
+{
+	/** ground location below the slot, or slot itself if there is no ground */
+	FVector Location;
+
+	/** set if ground was found below the slot */
+	uint8 bOnGround : 1;
+};
+
+/** Wave of UStrategyWaveSchedule resolved for spawning */
+struct FStrategySpawnPlanWave
+{
+	/** class of minions, already resolved to brewery's class if wave didn't set one */
+	TAssetSubclassOf<AStrategyChar> MinionClass;
+
+	/** weapon given to every minion */
+	TAssetSubclassOf<UStrategyAttachment> WeaponClass;
+
+	/** armor given to every minion */
+	TAssetSubclassOf<UStrategyAttachment> ArmorClass;
+
+	/** buff applied to every minion */
+	FBuffData Buff;
+
+	/** scale of minions */
+	float CustomScale;
+
+	/** animation rate of minions */
+	float AnimationRate;
+
+	/** time in seconds between end of previous wave and start of this one */
+	float Delay;
+
+	/** number of minions in the wave */
+	int32 NumMinions;
+};
 
 UCLASS()
 class UStrategyAIDirector : public UActorComponent
@@ -32,21 +73,29 @@ class UStrategyAIDirector : public UActorComponent
 	UFUNCTION(BlueprintCallable, Category=Pawn, meta=(DisplayName = "Set Unit Properties"))
 	void SetBuffModifier(AStrategyChar* Pawn, int32 AttackMin, int32 AttackMax, int32 DamageReduction, int32 MaxHealthBonus, int32 HealthRegen, float Speed, int32 DrunkLevel, float Duration, bool bInfiniteDuration, float CustomScale = 1.0, float AnimaRate = 1);
 
-	/** Number of pawns to spawn each wave */
+	/** set number of pawns to spawn and wake up spawning */
+	UFUNCTION(BlueprintCallable, Category=Minions)
+	void SetWaveSize(int32 InWaveSize);
+
+	/** Number of pawns to spawn each wave, use SetWaveSize while director is idle, direct writes don't wake it up */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Minions)
 	int32 WaveSize;
 
+	/** Waves to spawn, when set it replaces driving waves with WaveSize and Blueprint calls */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Minions)
+	UStrategyWaveSchedule* WaveSchedule;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category=Minions)
 	float RadiusToSpawnOn;
 
 protected:
 	/** default armor for spawns */
 	UPROPERTY()
-	TSubclassOf<UStrategyAttachment> DefaultArmor;
+	TAssetSubclassOf<UStrategyAttachment> DefaultArmor;
 
 	/** default weapon for spawns */
 	UPROPERTY()
-	TSubclassOf<UStrategyAttachment> DefaultWeapon;
+	TAssetSubclassOf<UStrategyAttachment> DefaultWeapon;
 
 	/** default modifier for spawns */
 	UPROPERTY()
@@ -60,7 +109,7 @@ public:
 	virtual void SetTeamNum(uint8 inTeamNum);
 
 	// Begin UActorComponent Interface
-	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction);
+	virtual void BeginPlay() override;
 	// End UActorComponent Interface
 
 	/** Getter for brewery of enemy side */
@@ -75,6 +124,88 @@ protected:
 	/** check conditions and spawn minions if possible */
 	void SpawnMinions();
 
+	/** spawn timer fired, spawn and schedule next one */
+	void OnSpawnTimer();
+
+	/** set spawn timer for NextSpawnTime, timer lapses while there is nothing to spawn */
+	void ScheduleSpawn();
+
+	/** find brewery of our enemy, once it exists */
+	void UpdateEnemyBrewery();
+
+	/** resolve WaveSchedule into spawn plan */
+	void BuildSpawnPlan();
+
+	/** take over settings of planned wave and start spawning it after its delay */
+	void StartPlannedWave(int32 WaveIdx);
+
+	/** check if classes of current wave are loaded, or not set at all */
+	bool AreSpawnClassesLoaded() const;
+
+	/** start async loading of classes of current wave, spawning is on hold until they are in */
+	void RequestSpawnClasses();
+
+	/**
+	 * Start async loading of classes in background, without waiting for them.
+	 *
+	 * @param	WaveIdx		Wave in SpawnPlan to load classes of.
+	 */
+	void PreloadPlannedWave(int32 WaveIdx);
+
+	/** add soft class reference to list of assets to load, if it isn't resident yet */
+	static void AddPendingClass(const FStringAssetReference& ClassRef, TArray<FStringAssetReference>& OutClassRefs);
+
+	/** classes requested by RequestSpawnClasses are loaded, ones that failed to load are replaced by brewery defaults */
+	void OnSpawnClassesLoaded();
+
+	/** fill pool with minions of every resident class we are going to spawn */
+	void PrewarmMinionPool();
+
+	/** find ground below every spawn slot */
+	void UpdateSpawnSlots();
+
+	/**
+	 * Pick spawn slot for next minion, one without units around if possible, otherwise the least crowded.
+	 *
+	 * @param	ClearanceRadius		Distance from slot at which units make it occupied, units only occupy their closest slot.
+	 * @returns index in SpawnSlots.
+	 */
+	int32 PickSpawnSlot(float ClearanceRadius);
+
+	/** get index in SpawnSlots of slot closest to location */
+	int32 GetClosestSpawnSlot(const FVector& Location) const;
+
+	/** navigation was rebuilt, static geometry may have changed */
+	UFUNCTION()
+	void OnNavigationGenerated(ANavigationData* NavData);
+
+	/** spawn slots in front of brewery, with their ground */
+	TArray<FStrategySpawnSlot> SpawnSlots;
+
+	/** set when ground of spawn slots needs to be found again */
+	uint8 bSpawnSlotsDirty : 1;
+
+	/** position in slot order of last used spawn slot */
+	int32 LastSpawnSlot;
+
+	/** waves resolved from WaveSchedule */
+	TArray<FStrategySpawnPlanWave> SpawnPlan;
+
+	/** index of wave being spawned in SpawnPlan, INDEX_NONE when not following a plan */
+	int32 CurrentPlanWave;
+
+	/** class of minions of planned wave, brewery's MinionCharClass is used if not set */
+	TAssetSubclassOf<AStrategyChar> WaveMinionClass;
+
+	/** set while waiting for classes of current wave to load */
+	uint8 bLoadingSpawnClasses : 1;
+
+	/** classes being loaded for current wave */
+	TArray<FStringAssetReference> RequestedSpawnClasses;
+
+	/** random stream for spawn intervals, seeded from WaveSchedule */
+	FRandomStream SpawnRandomStream;
+
 	/** Custom scale for spawns */
 	float CustomScale;
 
@@ -87,7 +218,13 @@ protected:
 	/** team number */
 	uint8 MyTeamNum;
 
+	/** Handle for spawn timer */
+	FTimerHandle TimerHandle_SpawnMinions;
+
 	/** Brewery of my biggest enemy */
 	TWeakObjectPtr<AStrategyBuilding_Brewery> EnemyBrewery;
+
+	/** squad of wave being spawned, minions join it as they spawn */
+	TSharedPtr<FStrategySquad> CurrentSquad;
 };
 
@@ -5,6 +5,33 @@
 #include "Perception/PawnSensingComponent.h"
 #include "StrategyAISensingComponent.generated.h"
 
+class FStrategyUnitGrid;
+
+/** Notification about target entering or leaving set of known targets, destroyed targets are reported as null */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnKnownTargetEvent, AActor*);
+
+/** State of a single sensor captured on game thread, so sight checks can run on worker threads */
+struct FStrategySensingQuery
+{
+	/** location we see from */
+	FVector SensorLocation;
+
+	/** direction we are looking at */
+	FVector SensorDirection;
+
+	/** maximum sight distance */
+	float SightRadius;
+
+	/** cosine of peripheral vision angle */
+	float PeripheralVisionCosine;
+
+	/** team of the sensor, units from other teams are sensed */
+	uint8 TeamNum;
+
+	/** random stream used to skip distant units */
+	FRandomStream RandomStream;
+};
+
 //感官组件。用于发现目标，听见目标或看见目标。
 /**
  * SensingComponent encapsulates sensory (ie sight and hearing) settings and functionality for an Actor,
@@ -16,9 +43,18 @@ class UStrategyAISensingComponent : public UPawnSensingComponent
 {
 	GENERATED_UCLASS_BODY()
 
-	/** list of known targets */
-	UPROPERTY()
-	TArray<TWeakObjectPtr<AActor> > KnownTargets;
+	//已知目标，以及最后一次看见的时间
+	/** set of known targets, with time they were last seen */
+	TMap<TWeakObjectPtr<AActor>, float> KnownTargets;
+
+	/** called when new target was added to known targets */
+	FOnKnownTargetEvent OnTargetSensed;
+
+	/** called when target was removed from known targets */
+	FOnKnownTargetEvent OnTargetLost;
+
+	/** time of last sensing update, maintained by UStrategyAISensingManager */
+	float LastSensingTime;
 
 	// Begin PawnSensingComponent interface
 
@@ -30,14 +66,45 @@ class UStrategyAISensingComponent : public UPawnSensingComponent
 
 	// End PawnSensingComponent interface
 
+	/**
+	 * Capture state of this sensor for a sensing pass. Game thread only.
+	 *
+	 * @param	OutQuery	Captured state.
+	 * @returns true if there is anything to sense.
+	 */
+	bool MakeSensingQuery(FStrategySensingQuery& OutQuery) const;
+
+	/**
+	 * Collect units visible for given query from the unit snapshot. Safe to call from worker threads.
+	 *
+	 * @param	UnitGrid	Grid holding the unit snapshot.
+	 * @param	Query		Captured sensor state.
+	 * @param	OutUnits	Array to append indices of sensed units to.
+	 */
+	static void GatherVisibleUnits(const FStrategyUnitGrid& UnitGrid, FStrategySensingQuery& Query, TArray<int32>& OutUnits);
+
+	/**
+	 * Add sensed units to known targets and forget dead ones, or ones not seen for too long.
+	 * Fires OnTargetSensed and OnTargetLost for every change. Game thread only.
+	 *
+	 * @param	UnitGrid	Grid holding the unit snapshot.
+	 * @param	SensedUnits	Indices of sensed units.
+	 */
+	void MergeSensedUnits(const FStrategyUnitGrid& UnitGrid, const TArray<int32>& SensedUnits);
+
 	/** Are we capable of sensing anything (and do we have any callbacks that care about sensing)? If so, calls UpdateAISensing(). */
 	virtual bool CanSenseAnything() const;
 
 	// Begin UActorComponent interface.
 	virtual void InitializeComponent() override;
+	virtual void UninitializeComponent() override;
 	// End UActorComponent interface.
 
 protected:
 	UPROPERTY(config)
 	float SightDistance;
+
+	/** time in seconds after which target not seen, either out of sight radius or behind cover, is forgotten */
+	UPROPERTY(config)
+	float TargetForgetTime;
 };
@@ -0,0 +1,177 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyAISensingComponent.h"
+#include "StrategyAISensingManager.generated.h"
+
+/** Pair of unit grid cells line of sight results are cached for */
+struct FStrategyLineOfSightKey
+{
+	/** cell of the observer */
+	FIntPoint ObserverCell;
+
+	/** cell of the target */
+	FIntPoint TargetCell;
+
+	FStrategyLineOfSightKey(const FIntPoint& InObserverCell, const FIntPoint& InTargetCell)
+		: ObserverCell(InObserverCell)
+		, TargetCell(InTargetCell)
+	{
+	}
+
+	bool operator==(const FStrategyLineOfSightKey& Other) const
+	{
+		return ObserverCell == Other.ObserverCell && TargetCell == Other.TargetCell;
+	}
+
+	friend uint32 GetTypeHash(const FStrategyLineOfSightKey& Key)
+	{
+		return HashCombine(GetTypeHash(Key.ObserverCell), GetTypeHash(Key.TargetCell));
+	}
+};
+
+/** Cached line of sight result between two cells */
+struct FStrategyLineOfSightEntry
+{
+	/** last known result, optimistic until first trace finishes */
+	uint8 bVisible : 1;
+
+	/** set while async trace is in flight */
+	uint8 bTracePending : 1;
+
+	/** time of last finished trace */
+	float ResultTime;
+
+	/** time of last trace request */
+	float RequestTime;
+
+	FStrategyLineOfSightEntry()
+		: bVisible(true)
+		, bTracePending(false)
+		, ResultTime(0.0f)
+		, RequestTime(0.0f)
+	{
+	}
+};
+
+/** Line of sight trace waiting to be issued */
+struct FStrategyLineOfSightRequest
+{
+	/** cache entry to update */
+	FStrategyLineOfSightKey Key;
+
+	/** trace start */
+	FVector Start;
+
+	/** trace end */
+	FVector End;
+
+	FStrategyLineOfSightRequest(const FStrategyLineOfSightKey& InKey, const FVector& InStart, const FVector& InEnd)
+		: Key(InKey)
+		, Start(InStart)
+		, End(InEnd)
+	{
+	}
+};
+
+// 感官管理器。每帧在时间预算内统一更新一部分感官组件。
+/**
+ * Owns every AI sensing component in the world and updates them in one place.
+ * Each frame the unit snapshot is refreshed once and a round-robin slice of due sensors
+ * is processed against it in parallel. Size of the slice is derived from the per frame time budget
+ * and measured cost of previous passes.
+ * Line of sight is checked with batched async traces, cached per pair of observer and target cells.
+ */
+UCLASS(config=Game)
+class UStrategyAISensingManager : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Maximum time in milliseconds spent on sensing in a single frame */
+	UPROPERTY(config)
+	float MaxSensingTimePerFrame;
+
+	/** Time in seconds a cached line of sight result is considered fresh */
+	UPROPERTY(config)
+	float LineOfSightCacheTTL;
+
+	/** Maximum number of async line of sight traces issued in a single frame */
+	UPROPERTY(config)
+	int32 MaxLineOfSightTracesPerFrame;
+
+	// Begin UActorComponent Interface
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	// End UActorComponent Interface
+
+	/**
+	 * Start updating sensor.
+	 *
+	 * @param	Sensor	The sensing component to update.
+	 */
+	void RegisterSensor(UStrategyAISensingComponent* Sensor);
+
+	/**
+	 * Stop updating sensor.
+	 *
+	 * @param	Sensor	The sensing component to forget.
+	 */
+	void UnregisterSensor(UStrategyAISensingComponent* Sensor);
+
+	/**
+	 * Remove units not visible from sensor, according to cached line of sight results.
+	 * Missing or stale results are queued for async traces, last known result is used until they finish.
+	 *
+	 * @param	UnitGrid		Grid holding the unit snapshot.
+	 * @param	SensorLocation	Location we see from.
+	 * @param	InOutUnits		Indices of units to filter.
+	 */
+	void FilterByLineOfSight(const FStrategyUnitGrid& UnitGrid, const FVector& SensorLocation, TArray<int32>& InOutUnits);
+
+protected:
+	/** issue queued line of sight traces, up to per frame limit */
+	void IssueLineOfSightTraces();
+
+	/** async line of sight trace finished */
+	void OnLineOfSightTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** drop cached results nobody asked for in a long time */
+	void PruneLineOfSightCache(float CurrentTime);
+
+	/** all registered sensors */
+	UPROPERTY()
+	TArray<UStrategyAISensingComponent*> Sensors;
+
+	/** sensor to start with in next frame */
+	int32 NextSensorIndex;
+
+	/** measured time in seconds of sensing for a single sensor, averaged over frames */
+	double AverageSensorTime;
+
+	/** sensors processed in current frame */
+	TArray<UStrategyAISensingComponent*> DueSensors;
+
+	/** captured state of sensors processed in current frame */
+	TArray<FStrategySensingQuery> DueQueries;
+
+	/** units sensed by each sensor processed in current frame, written by worker threads */
+	TArray<TArray<int32> > SensedUnits;
+
+	/** cached line of sight results */
+	TMap<FStrategyLineOfSightKey, FStrategyLineOfSightEntry> LineOfSightCache;
+
+	/** line of sight traces waiting to be issued */
+	TArray<FStrategyLineOfSightRequest> LineOfSightRequests;
+
+	/** cache entries of traces in flight, by trace user data */
+	TMap<uint32, FStrategyLineOfSightKey> LineOfSightTraces;
+
+	/** user data of next issued trace */
+	uint32 NextLineOfSightTraceId;
+
+	/** delegate called for finished line of sight traces */
+	FTraceDelegate LineOfSightTraceDelegate;
+
+	/** time of last cache pruning */
+	float LastLineOfSightPruneTime;
+};
@@ -0,0 +1,69 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "StrategyAITargetingManager.generated.h"
+
+class AStrategyAIController;
+
+// 目标分配管理器。按阵营统一为所有AI控制器分配攻击目标。
+/**
+ * Assigns attack targets to all AI controllers of a team in one batch.
+ * Pairs of attacker and known target are sorted by cost (squared distance, with a bonus for keeping current target)
+ * and assigned greedily, so that no target takes more than MaxAttackersPerTarget attackers while others are free.
+ * Attackers left over pick their cheapest target with a penalty per attacker already assigned to it.
+ * Teams are solved at a fixed rate, so assignments follow units as they move closer or further apart.
+ * Each team solves in its own part of TargetingInterval and at most one team is solved per frame.
+ */
+UCLASS(config=Game)
+class UStrategyAITargetingManager : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Time in seconds between two assignments of the same team */
+	UPROPERTY(config)
+	float TargetingInterval;
+
+	/** Number of attackers a target takes before others are preferred */
+	UPROPERTY(config)
+	int32 MaxAttackersPerTarget;
+
+	/** Distance added to the cost of a target for each attacker already assigned to it */
+	UPROPERTY(config)
+	float AttackerCostDistance;
+
+	/** Distance subtracted from the cost of current target, prevents flipping between targets at similar distance */
+	UPROPERTY(config)
+	float CurrentTargetBonusDistance;
+
+	// Begin UActorComponent Interface
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	// End UActorComponent Interface
+
+	/**
+	 * Start assigning targets to controller.
+	 *
+	 * @param	Controller	The controller to assign targets to.
+	 */
+	void RegisterController(AStrategyAIController* Controller);
+
+	/**
+	 * Stop assigning targets to controller.
+	 *
+	 * @param	Controller	The controller to forget.
+	 */
+	void UnregisterController(AStrategyAIController* Controller);
+
+protected:
+	/** assign targets to all controllers of given team */
+	void SolveTeam(uint8 TeamNum);
+
+	/** all registered controllers */
+	UPROPERTY()
+	TArray<AStrategyAIController*> Controllers;
+
+	/** time of last assignment for each team */
+	float LastSolveTime[EStrategyTeam::MAX];
+};
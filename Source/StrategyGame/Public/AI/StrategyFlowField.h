@@ -0,0 +1,151 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+class UNavigationSystem;
+
+// 流场寻路。对同一个目标只计算一次，所有单位共享。
+/**
+ * Flow field toward a single goal over the navigable area of the level.
+ * Cell centers are projected to navigation once and neighbors are only linked when navigation connects
+ * their centers in a straight line. Integration field holds travel cost to the goal
+ * and direction field points every walkable cell to its cheapest linked neighbor.
+ * Any number of units can then walk toward the goal without their own path queries.
+ * Building is split in steps that can be spread over several frames.
+ */
+class FStrategyFlowField
+{
+public:
+	FStrategyFlowField();
+
+	/**
+	 * Start building the field, previous data is dropped. Call UpdateBuild until it finishes.
+	 *
+	 * @param	World			World to sample navigation of.
+	 * @param	GoalLocation	Location to flow toward.
+	 * @param	InCellSize		Edge length of a cell in world units.
+	 */
+	void StartBuild(UWorld* World, const FVector& GoalLocation, float InCellSize);
+
+	/**
+	 * Continue building the field until it's finished or time runs out.
+	 *
+	 * @param	World		World to sample navigation of.
+	 * @param	EndTime		Platform time in seconds to stop at.
+	 * @returns true if building finished, IsValid tells if the goal can be reached.
+	 */
+	bool UpdateBuild(UWorld* World, double EndTime);
+
+	/** Drop all data, field needs to be built again. */
+	void Reset();
+
+	/** Check if the field is being built. */
+	bool IsBuilding() const;
+
+	/** Check if the field was built and can be followed. */
+	bool IsValid() const;
+
+	/** Get size of a single cell. */
+	float GetCellSize() const;
+
+	/** Get location the field was built for. */
+	const FVector& GetGoalLocation() const;
+
+	/**
+	 * Find next waypoint toward the goal, following the direction field in a straight line.
+	 *
+	 * @param	FromLocation	Location to start from.
+	 * @param	MaxSteps		Maximum number of cells to walk.
+	 * @param	OutWaypoint		Found waypoint, on navigation.
+	 * @returns false if location is outside the field, cannot reach the goal or is already in goal cell.
+	 */
+	bool GetWaypoint(const FVector& FromLocation, int32 MaxSteps, FVector& OutWaypoint) const;
+
+protected:
+	/** steps of building the field */
+	enum EBuildStep
+	{
+		BuildIdle,
+		BuildSampling,
+		BuildLinking,
+		BuildIntegrating,
+	};
+
+	/** node of the open list */
+	struct FOpenNode
+	{
+		int32 Index;
+		float Cost;
+
+		FOpenNode(int32 InIndex, float InCost)
+			: Index(InIndex)
+			, Cost(InCost)
+		{
+		}
+
+		bool operator<(const FOpenNode& Other) const
+		{
+			return Cost < Other.Cost;
+		}
+	};
+
+	/** project center of cell to navigation */
+	void SampleCell(UNavigationSystem* NavSys, int32 Index);
+
+	/** link cell with neighbors reachable in a straight line */
+	void LinkCell(UWorld* World, int32 Index);
+
+	/** seed open list with walkable cells around the goal */
+	void SeedGoal();
+
+	/** relax neighbors of a node taken from the open list */
+	void IntegrateNode(const FOpenNode& Node);
+
+	/** get index of cell containing location, or INDEX_NONE */
+	int32 GetCellIndex(const FVector& Location) const;
+
+	/** get center of cell, at projected navigation height */
+	FVector GetCellLocation(int32 Index) const;
+
+	/** edge length of a cell */
+	float CellSize;
+
+	/** world location of corner of the first cell */
+	FVector2D Origin;
+
+	/** number of cells along X */
+	int32 SizeX;
+
+	/** number of cells along Y */
+	int32 SizeY;
+
+	/** location the field flows to */
+	FVector GoalLocation;
+
+	/** navigation height of each cell, MAX_FLT for cells without navigation */
+	TArray<float> Heights;
+
+	/** bit mask of neighbors reachable from each cell in a straight line */
+	TArray<uint8> Links;
+
+	/** integration field, travel cost from each cell to the goal */
+	TArray<float> Costs;
+
+	/** direction field, index of neighbor to move to from each cell */
+	TArray<uint8> Directions;
+
+	/** current step of building */
+	EBuildStep BuildStep;
+
+	/** next cell to process in current step */
+	int32 NextBuildCell;
+
+	/** extent of navigation projections */
+	FVector ProjectExtent;
+
+	/** height cell centers are projected from */
+	float ProjectCenterZ;
+
+	/** open list of integration step */
+	TArray<FOpenNode> OpenList;
+};
@@ -0,0 +1,149 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "AI/Navigation/NavigationTypes.h"
+
+class AAIController;
+
+/** Delivers path found for a request, invalid pointer if there is none */
+DECLARE_DELEGATE_OneParam(FOnStrategyPathFound, FNavPathSharedPtr);
+
+// 路径缓存。起点相近、目标相同的寻路请求共用一条路径。
+/**
+ * Cache of paths keyed by quantized start cell and goal (actor, or quantized location).
+ * Units clumped around the same spot heading to the same goal get a copy of one path instead of
+ * running their own query. Misses are solved asynchronously, and requests for a key already being
+ * solved wait for the same query. Failed queries are cached as well, so an unreachable goal is only queried
+ * once per TTL. Hit, miss and coalesced counters show how much path work is saved.
+ */
+class FStrategyPathCache
+{
+public:
+	FStrategyPathCache();
+
+	/**
+	 * Set quantization and lifetime of cached paths, drops everything cached or in flight.
+	 *
+	 * @param	InCellSize			Edge length of start cells in world units.
+	 * @param	InTTL				Time in seconds a cached path can be reused.
+	 * @param	InOnQueryFinished	Bound to owning object, must pass results to OnPathQueryFinished. Results of queries
+	 *								still in flight are dropped with it when the owner goes away.
+	 */
+	void Configure(float InCellSize, float InTTL, const FNavPathQueryDelegate& InOnQueryFinished);
+
+	/**
+	 * Request path from controller's pawn to goal. Cache hits, including cached failures, are delivered right away,
+	 * misses once the async query finishes. Delivered path is a private copy, safe to hand over to path following.
+	 *
+	 * @param	Controller		Controller asking for the path.
+	 * @param	GoalActor		Actor to move to, or null to move to location.
+	 * @param	GoalLocation	Location to move to, ignored when moving to actor.
+	 * @param	OnPathFound		Called with the path.
+	 */
+	void RequestPath(AAIController* Controller, AActor* GoalActor, const FVector& GoalLocation, const FOnStrategyPathFound& OnPathFound);
+
+	/**
+	 * Async path query finished, serve everyone waiting for it.
+	 *
+	 * @param	QueryId		Id of finished query.
+	 * @param	Result		Result of the query.
+	 * @param	Path		Path found, if any.
+	 * @param	CurrentTime	World time the query finished at, cached path lives TTL from it.
+	 */
+	void OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path, float CurrentTime);
+
+	/** Get number of requests served from cache. */
+	int32 GetNumHits() const;
+
+	/** Get number of requests which started a path query. */
+	int32 GetNumMisses() const;
+
+	/** Get number of requests which joined a query already in flight. */
+	int32 GetNumCoalesced() const;
+
+protected:
+	/** quantized start and goal of a path */
+	struct FPathKey
+	{
+		FIntPoint StartCell;
+		FIntPoint GoalCell;
+		const AActor* GoalActor;
+
+		FPathKey()
+			: GoalActor(nullptr)
+		{
+		}
+
+		FPathKey(const FIntPoint& InStartCell, const FIntPoint& InGoalCell, const AActor* InGoalActor)
+			: StartCell(InStartCell)
+			, GoalCell(InGoalCell)
+			, GoalActor(InGoalActor)
+		{
+		}
+
+		bool operator==(const FPathKey& Other) const
+		{
+			return StartCell == Other.StartCell && GoalCell == Other.GoalCell && GoalActor == Other.GoalActor;
+		}
+
+		friend uint32 GetTypeHash(const FPathKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.GoalCell)), PointerHash(Key.GoalActor));
+		}
+	};
+
+	/** cached path with time it was found, invalid path if query failed */
+	struct FPathEntry
+	{
+		FNavPathSharedPtr Path;
+		float Time;
+	};
+
+	/** query in flight with everyone waiting for it */
+	struct FPendingPath
+	{
+		uint32 QueryId;
+		TWeakObjectPtr<AActor> GoalActor;
+		TArray<FOnStrategyPathFound> Waiters;
+	};
+
+	/** make a private copy of cached path, observing goal actor if there is one */
+	static FNavPathSharedPtr CopyPath(const FNavPathSharedPtr& Path, AActor* GoalActor);
+
+	/** get cell containing location */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** drop expired entries */
+	void Prune(float CurrentTime);
+
+	/** edge length of start cells */
+	float CellSize;
+
+	/** time in seconds a cached path can be reused */
+	float TTL;
+
+	/** time of last pruning */
+	float LastPruneTime;
+
+	/** passes results of async path queries back to OnPathQueryFinished */
+	FNavPathQueryDelegate OnQueryFinished;
+
+	/** cached paths */
+	TMap<FPathKey, FPathEntry> Paths;
+
+	/** queries in flight */
+	TMap<FPathKey, FPendingPath> PendingPaths;
+
+	/** keys of queries in flight, by query id */
+	TMap<uint32, FPathKey> PendingQueries;
+
+	/** number of requests served from cache */
+	int32 NumHits;
+
+	/** number of requests which started a path query */
+	int32 NumMisses;
+
+	/** number of requests which joined a query already in flight */
+	int32 NumCoalesced;
+};
@@ -0,0 +1,55 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+class AStrategyAIController;
+
+// 小队。同一波生成的单位组成一个小队，队长寻路，队员保持阵型跟随。
+/**
+ * Units spawned in the same wave. The first live member leads and finds the way,
+ * everyone else walks to a formation slot behind the leader until they engage.
+ */
+class FStrategySquad
+{
+public:
+	FStrategySquad();
+
+	/**
+	 * Add unit to the squad.
+	 *
+	 * @param	Member	Controller of the unit.
+	 */
+	void AddMember(AStrategyAIController* Member);
+
+	/**
+	 * Remove unit from the squad, next member takes the lead if it was leading.
+	 *
+	 * @param	Member	Controller of the unit.
+	 */
+	void RemoveMember(AStrategyAIController* Member);
+
+	/** Get controller leading the squad, first member with a live pawn. */
+	AStrategyAIController* GetLeader() const;
+
+	/**
+	 * Get location of formation slot of a member, relative to the leader.
+	 *
+	 * @param	Member		Controller of the unit.
+	 * @param	OutLocation	Location of the slot.
+	 * @returns false if there is no leader or member is the leader.
+	 */
+	bool GetFormationLocation(const AStrategyAIController* Member, FVector& OutLocation) const;
+
+	/** Distance between formation slots */
+	float FormationSpacing;
+
+	/** Number of slots in a single formation row */
+	int32 FormationRowSize;
+
+protected:
+	/** get index of member, INDEX_NONE if it's not one of ours */
+	int32 FindMember(const AStrategyAIController* Member) const;
+
+	/** all members, in order they joined */
+	TArray<TWeakObjectPtr<AStrategyAIController> > Members;
+};
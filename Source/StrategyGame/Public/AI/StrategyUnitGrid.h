@@ -0,0 +1,132 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+
+class AStrategyChar;
+
+/**
+ * Per frame snapshot of all tracked units, stored as structure of arrays.
+ * All arrays share the same indexing, which is the unit index used by FStrategyUnitGrid.
+ * Read-only access is safe from worker threads between two refreshes.
+ */
+struct FStrategyUnitSnapshot
+{
+	/** tracked characters, only to be dereferenced on game thread */
+	TArray<AStrategyChar*> Chars;
+
+	/** locations at the time of last refresh */
+	TArray<FVector> Locations;
+
+	/** cells units are bucketed in */
+	TArray<FIntPoint> Cells;
+
+	/** health at the time of last refresh */
+	TArray<int32> Healths;
+
+	/** teams units are bucketed in */
+	TArray<uint8> TeamNums;
+
+	/** hidden in game at the time of last refresh */
+	TArray<uint8> HiddenFlags;
+
+	/** get number of units */
+	int32 Num() const { return Chars.Num(); }
+};
+
+// 按阵营划分的均匀空间哈希，记录所有存活的角色。
+/**
+ * Uniform spatial hash of live minions, bucketed by team.
+ * Proximity queries only visit cells around the query point instead of every pawn in the world.
+ * Units are kept in a dense snapshot of their location, team and health, refreshed once per frame.
+ */
+class FStrategyUnitGrid
+{
+public:
+	FStrategyUnitGrid();
+
+	/**
+	 * Set size of a single cell, already tracked units are re-bucketed.
+	 *
+	 * @param	InCellSize	Edge length of a cell in world units.
+	 */
+	void SetCellSize(float InCellSize);
+
+	/** Get size of a single cell. */
+	float GetCellSize() const;
+
+	/**
+	 * Start tracking a unit.
+	 *
+	 * @param	InChar	The character to track.
+	 */
+	void AddUnit(AStrategyChar* InChar);
+
+	/**
+	 * Stop tracking a unit.
+	 *
+	 * @param	InChar	The character to forget.
+	 */
+	void RemoveUnit(AStrategyChar* InChar);
+
+	/**
+	 * Refresh snapshot of a single tracked unit, call after it changed team.
+	 *
+	 * @param	InChar	The character to update.
+	 */
+	void UpdateUnit(AStrategyChar* InChar);
+
+	/** Refresh snapshot of all tracked units, expected to be called once per frame. */
+	void RefreshUnits();
+
+	/**
+	 * Collect units of given team from all cells overlapping a circle.
+	 * Units are not distance tested, callers are expected to do their own exact checks.
+	 * Safe to call from worker threads as long as the grid is not modified at the same time.
+	 *
+	 * @param	Center		Center of the query.
+	 * @param	Radius		Radius of the query.
+	 * @param	TeamNum		Team of units to collect.
+	 * @param	OutUnits	Array to append indices of found units to.
+	 */
+	void GatherUnits(const FVector& Center, float Radius, uint8 TeamNum, TArray<int32>& OutUnits) const;
+
+	/**
+	 * Find distance to the closest live unit not in given team.
+	 *
+	 * @param	Location	Location to measure from.
+	 * @param	Radius		Maximum distance to look at.
+	 * @param	TeamNum		Team of the asking unit, its units are skipped.
+	 * @returns squared distance to closest enemy, or MAX_FLT if there is none within radius.
+	 */
+	float GetNearestEnemyDistSquared(const FVector& Location, float Radius, uint8 TeamNum) const;
+
+	/** Get cell containing given location. */
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** Get number of tracked units. */
+	int32 GetNumUnits() const;
+
+	/** Get snapshot of all tracked units. */
+	const FStrategyUnitSnapshot& GetSnapshot() const;
+
+protected:
+	/** refresh snapshot of unit stored at given index and re-bucket it if needed */
+	void RefreshUnit(int32 Index);
+
+	/** remove unit from its bucket */
+	void RemoveFromCell(int32 Index);
+
+	/** edge length of a cell */
+	float CellSize;
+
+	/** snapshot of all tracked units */
+	FStrategyUnitSnapshot Snapshot;
+
+	/** unit index of every tracked character */
+	TMap<AStrategyChar*, int32> UnitIndices;
+
+	/** indices of units stored per cell, for each team */
+	TMap<FIntPoint, TArray<int32> > Cells[EStrategyTeam::MAX];
+};
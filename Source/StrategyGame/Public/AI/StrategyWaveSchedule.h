@@ -0,0 +1,90 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "StrategyWaveSchedule.generated.h"
+
+class AStrategyChar;
+class UStrategyAttachment;
+
+/** Single wave of minions spawned by UStrategyAIDirector */
+USTRUCT()
+struct FStrategyWaveInfo
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** number of minions in the wave */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	int32 NumMinions;
+
+	/** time in seconds between end of previous wave and start of this one */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	float Delay;
+
+	/** class of minions, brewery's MinionCharClass is used if not set */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	TAssetSubclassOf<AStrategyChar> MinionClass;
+
+	/** weapon given to every minion */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	TAssetSubclassOf<UStrategyAttachment> WeaponClass;
+
+	/** armor given to every minion */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	TAssetSubclassOf<UStrategyAttachment> ArmorClass;
+
+	/** buff applied to every minion */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	FBuffData Buff;
+
+	/** scale of minions */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	float CustomScale;
+
+	/** animation rate of minions */
+	UPROPERTY(EditDefaultsOnly, Category=Wave)
+	float AnimationRate;
+
+	/** defaults */
+	FStrategyWaveInfo()
+		: NumMinions(3)
+		, Delay(10.0f)
+		, CustomScale(1.0f)
+		, AnimationRate(1.0f)
+	{
+		// buff only changes what the wave sets, not pawn defaults
+		Buff.BuffData.AttackMin = 0;
+		Buff.BuffData.AttackMax = 0;
+		Buff.BuffData.AttackDistance = 0;
+		Buff.BuffData.DamageReduction = 0;
+		Buff.BuffData.MaxHealthBonus = 0;
+		Buff.BuffData.HealthRegen = 0;
+		Buff.BuffData.Speed = 0;
+		Buff.bInfiniteDuration = true;
+	}
+};
+
+// 出怪计划。列出每一波怪物的数量、种类、buff和装备。
+/**
+ * Schedule of waves spawned by UStrategyAIDirector, replaces driving waves from Blueprint.
+ * With a fixed random seed the same schedule gives the same spawn load every run.
+ * Classes are soft references, director streams them in while the previous wave is still spawning.
+ */
+UCLASS(BlueprintType)
+class UStrategyWaveSchedule : public UDataAsset
+{
+	GENERATED_UCLASS_BODY()
+
+	/** waves in order they are spawned */
+	UPROPERTY(EditDefaultsOnly, Category=Waves)
+	TArray<FStrategyWaveInfo> Waves;
+
+	/** start over from first wave after last one */
+	UPROPERTY(EditDefaultsOnly, Category=Waves)
+	uint32 bLoop : 1;
+
+	/** seed for spawn intervals, 0 to pick a random one */
+	UPROPERTY(EditDefaultsOnly, Category=Waves)
+	int32 RandomSeed;
+};
@@ -18,4 +18,15 @@ class UStrategyAttachment : public USkeletalMeshComponent
 	/** Attach point on pawn */
 	UPROPERTY(EditDefaultsOnly, Category=Attachment)
 	FName AttachPoint;
+
+	/**
+	 * Attach to body mesh of pawn without evaluating a skeleton of our own.
+	 * Meshes skinned to body skeleton follow its pose, rigid props in sockets keep their reference pose.
+	 *
+	 * @param	BodyMesh	Mesh of the pawn to attach to.
+	 */
+	void AttachToBody(USkeletalMeshComponent* BodyMesh);
+
+	/** Detach from body mesh and stop following its pose. */
+	void DetachFromBody();
 };
@@ -8,6 +8,7 @@
 
 
 class UStrategyAttachment;
+class AStrategyAIController;
 
 // Base class for the minions
 UCLASS(Abstract)
@@ -29,6 +30,14 @@ class AStrategyChar : public ACharacter, public IStrategyTeamInterface
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Health)
 	float Health;
 
+	/** How mesh updates while not rendered, AlwaysTickPose keeps montages and notifies running without refreshing bones */
+	UPROPERTY(EditDefaultsOnly, Category=Animation)
+	TEnumAsByte<EMeshComponentUpdateFlag::Type> MeshUpdateFlag;
+
+	/** Let mesh update less often when pawn is small on screen */
+	UPROPERTY(EditDefaultsOnly, Category=Animation)
+	uint32 bMeshUpdateRateOptimizations:1;
+
 public:
 
 	/**
@@ -48,9 +57,18 @@ public:
 	/** initial setup */
 	virtual void PostInitializeComponents() override;
 
+	/** register in unit grid */
+	virtual void BeginPlay() override;
+
+	/** unregister from unit grid */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** prevent units from basing on each other or buildings */
 	virtual bool CanBeBaseForCharacter(APawn* Pawn) const override;
 
+	/** reuse controller we had before sleeping in minion pool */
+	virtual void SpawnDefaultController() override;
+
 	/** don't export collisions for navigation */
 	virtual bool IsComponentRelevantForNavigation(UActorComponent* Component) const override { return false; }
 
@@ -93,6 +111,25 @@ public:
 	UFUNCTION(BlueprintCallable, Category=Attachment)
 	bool IsArmorAttached();
 
+	/** get attachment in weapon slot */
+	UStrategyAttachment* GetWeaponAttachment() const { return WeaponSlot; }
+
+	/** get attachment in armor slot */
+	UStrategyAttachment* GetArmorAttachment() const { return ArmorSlot; }
+
+	// 进入对象池休眠
+	/** hide and stop dead pawn, so it can be reused by UStrategyMinionPool */
+	void SleepInPool();
+
+	// 从对象池中唤醒，恢复到刚生成时的状态
+	/**
+	 * Bring pooled pawn back to the state it was spawned in. Team, buffs and controller are set up by the spawner.
+	 *
+	 * @param	Location	Location to place pawn at.
+	 * @param	Rotation	Rotation to place pawn with.
+	 */
+	void WakeFromPool(const FVector& Location, const FRotator& Rotation);
+
 	/** set team number */
 	void SetTeamNum(uint8 NewTeamNum); 
 
@@ -133,6 +170,10 @@ protected:
 	UPROPERTY()
 	UStrategyAttachment* WeaponSlot;
 
+	/** AI controller we had before dying, kept while sleeping in minion pool */
+	UPROPERTY()
+	AStrategyAIController* PooledController;
+
 	// 阵营编号
 	/** team number */
 	uint8 MyTeamNum;
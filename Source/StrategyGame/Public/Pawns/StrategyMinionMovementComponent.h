@@ -0,0 +1,79 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyTypes.h"
+#include "StrategyMinionMovementComponent.generated.h"
+
+// 怪物的移动组件。寻路请求的速度经过UStrategyAIAvoidanceManager调整后才使用。
+/**
+ * Character movement of minions.
+ * Velocity requested by path following is recorded as desired velocity for local avoidance,
+ * and replaced by the velocity UStrategyAIAvoidanceManager computed for us, while it's fresh.
+ * Minions walk on navmesh (MOVE_NavWalking) instead of sweeping their capsule against the world.
+ * A periodic async overlap test looks for blocking dynamic objects navmesh doesn't know about,
+ * and switches to full collision walking while one is close.
+ */
+UCLASS(config=Game)
+class UStrategyMinionMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Time in seconds between two checks for blocking dynamic objects */
+	UPROPERTY(config)
+	float DynamicObstacleCheckInterval;
+
+	/** Distance from capsule within which dynamic objects switch us to full collision */
+	UPROPERTY(config)
+	float DynamicObstacleMargin;
+
+	// Begin UActorComponent Interface
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	// End UActorComponent Interface
+
+	// Begin UNavMovementComponent Interface
+	virtual void RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed) override;
+	virtual void StopActiveMovement() override;
+	// End UNavMovementComponent Interface
+
+	/** Get velocity last requested by path following, zero if we were not asked to move lately */
+	FVector GetDesiredMoveVelocity() const;
+
+	/**
+	 * Set velocity adjusted by local avoidance, used in place of requested velocity until it gets stale.
+	 *
+	 * @param	InVelocity	Velocity which keeps us clear of units around.
+	 */
+	void SetAvoidanceVelocity(const FVector& InVelocity);
+
+	/** Time in seconds requested and avoidance velocities are considered fresh */
+	float MoveVelocityTTL;
+
+protected:
+	/** issue async overlap test for blocking dynamic objects, when it's time */
+	void UpdateDynamicObstacleCheck(float DeltaTime);
+
+	/** async overlap test for blocking dynamic objects finished */
+	void OnDynamicObstacleCheckDone(const FTraceHandle& TraceHandle, FOverlapDatum& OverlapDatum);
+
+	/** delegate called for finished overlap tests */
+	FOverlapDelegate DynamicObstacleCheckDelegate;
+
+	/** time left to next check for blocking dynamic objects */
+	float DynamicObstacleCheckTimer;
+
+	/** set while overlap test is in flight */
+	uint8 bDynamicObstacleCheckPending : 1;
+
+	/** velocity last requested by path following */
+	FVector DesiredMoveVelocity;
+
+	/** velocity adjusted by local avoidance */
+	FVector AdjustedMoveVelocity;
+
+	/** time of last move request */
+	float DesiredMoveTime;
+
+	/** time of last avoidance update */
+	float AdjustedMoveTime;
+};
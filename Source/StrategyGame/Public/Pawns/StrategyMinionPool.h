@@ -0,0 +1,65 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "StrategyMinionPool.generated.h"
+
+class AStrategyChar;
+
+// 怪物对象池。死亡的怪物连同它的AI控制器和装备一起休眠，下一次生成时重新使用。
+/**
+ * Keeps dead minions asleep, together with their AI controllers and attachments, to be used by the next spawn.
+ * Minions are pooled per class, a few of each class can be spawned ahead when the match starts.
+ */
+UCLASS(config=Game)
+class UStrategyMinionPool : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	/** Number of minions of each class spawned ahead */
+	UPROPERTY(config)
+	int32 PrewarmCount;
+
+	/** Maximum number of sleeping minions kept for each class */
+	UPROPERTY(config)
+	int32 MaxPooledPerClass;
+
+	/**
+	 * Spawn minions of given class ahead, only first call for each class does anything.
+	 *
+	 * @param	CharClass	Class of minions to spawn.
+	 * @param	Location	Location to spawn them at, they stay hidden.
+	 */
+	void Prewarm(TSubclassOf<AStrategyChar> CharClass, const FVector& Location);
+
+	/**
+	 * Wake up pooled minion of given class, or spawn a new one if there is none.
+	 * Controller is not possessed yet, SpawnDefaultController reuses the one minion had.
+	 *
+	 * @param	CharClass	Class of minion to get.
+	 * @param	Location	Location to place minion at.
+	 * @param	Rotation	Rotation to place minion with.
+	 * @returns minion ready to be set up, null if spawn failed.
+	 */
+	AStrategyChar* AcquireMinion(TSubclassOf<AStrategyChar> CharClass, const FVector& Location, const FRotator& Rotation);
+
+	/**
+	 * Put dead minion to sleep in the pool.
+	 *
+	 * @param	InChar	Minion which finished dying.
+	 * @returns false if there is no room for it, it should be destroyed then.
+	 */
+	bool ReleaseMinion(AStrategyChar* InChar);
+
+protected:
+	/** get number of sleeping minions of given class */
+	int32 GetNumPooled(UClass* CharClass) const;
+
+	/** sleeping minions of all classes */
+	UPROPERTY()
+	TArray<AStrategyChar*> PooledChars;
+
+	/** classes already spawned ahead */
+	UPROPERTY()
+	TArray<UClass*> PrewarmedClasses;
+};
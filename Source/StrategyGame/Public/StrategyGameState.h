@@ -4,9 +4,20 @@
 
 #include "StrategyTypes.h"
 #include "StrategyMiniMapCapture.h"
+#include "StrategyUnitGrid.h"
+#include "StrategyAIClaimTable.h"
+#include "StrategyFlowField.h"
+#include "StrategyPathCache.h"
+#include "Engine/StreamableManager.h"
 #include "StrategyGameState.generated.h"
 
 class AStrategyChar;
+class UStrategyAISensingManager;
+class UStrategyAITargetingManager;
+class UStrategyAIDecisionScheduler;
+class UStrategyAIAvoidanceManager;
+class UStrategyMinionPool;
+class ANavigationData;
 /*class AStrategyMiniMapCapture;*/
 
 /* 游戏状态类，只记录状态和数据，不作逻辑处理。
@@ -33,6 +44,34 @@ public:
 	UPROPERTY(config)
 	int32 WarmupTime;
 
+	// 角色空间哈希的格子大小
+	/** Size of a single cell in the unit grid */
+	UPROPERTY(config)
+	float UnitGridCellSize;
+
+	// 流场的格子大小
+	/** Size of a single cell in flow fields */
+	UPROPERTY(config)
+	float FlowFieldCellSize;
+
+	/** Maximum time in milliseconds spent on building flow fields in a single frame */
+	UPROPERTY(config)
+	float MaxFlowFieldBuildTimePerFrame;
+
+	// 路径缓存中起点格子的大小
+	/** Size of start cells paths are cached for */
+	UPROPERTY(config)
+	float PathCacheCellSize;
+
+	/** Time in seconds a cached path can be reused */
+	UPROPERTY(config)
+	float PathCacheTTL;
+
+	// Begin Actor interface
+	/** initial setup */
+	virtual void PostInitializeComponents() override;
+	// End Actor interface
+
 	/** Current difficulty level of the game. */
 	EGameDifficulty::Type GameDifficulty;
 
@@ -123,12 +162,114 @@ public:
 	 */
 	void SetGameDifficulty(EGameDifficulty::Type NewDifficulty);
 
+	/** Notify that a brewery was added or changed, invalidates AI decisions depending on breweries. */
+	void NotifyBreweryChanged();
+
+	/** Get counter incremented on every brewery change. */
+	uint32 GetBreweryEpoch() const;
+
+	/**
+	 * Get flow field toward given goal. It's built over several frames, starting with first request,
+	 * and rebuilt after navigation changes.
+	 *
+	 * @param	Goal	Actor to flow toward.
+	 * @returns the field, or null if it's still being built or goal can't be reached.
+	 */
+	const FStrategyFlowField* GetFlowField(AActor* Goal);
+
+	/** Get cache of paths toward goal actors. */
+	FStrategyPathCache& GetPathCache();
+
+	/** Get cache of paths toward goal actors. */
+	const FStrategyPathCache& GetPathCache() const;
+
+	/** Get spatial hash of all live characters. */
+	FStrategyUnitGrid& GetUnitGrid();
+
+	/** Get manager updating all AI sensing components. */
+	UStrategyAISensingManager* GetSensingManager() const;
+
+	/** Get registry of AI controllers claimed as targets. */
+	FStrategyAIClaimTable& GetClaimTable();
+
+	/** Get registry of AI controllers claimed as targets. */
+	const FStrategyAIClaimTable& GetClaimTable() const;
+
+	/** Get manager assigning targets to AI controllers. */
+	UStrategyAITargetingManager* GetTargetingManager() const;
+
+	/** Get scheduler running AI decisions under per frame budget. */
+	UStrategyAIDecisionScheduler* GetDecisionScheduler() const;
+
+	/** Get manager steering minions clear of each other. */
+	UStrategyAIAvoidanceManager* GetAvoidanceManager() const;
+
+	/** Get pool of dead minions waiting for reuse. */
+	UStrategyMinionPool* GetMinionPool() const;
+
+	/** Get streamable manager loading classes of spawned minions and their attachments. */
+	FStreamableManager& GetStreamableManager();
+
 protected:
 	// 两个阵营的玩家数据
 	// @todo, get rid of mutable?
 	/** Gameplay information about each player. */	
 	mutable TArray<FPlayerData> PlayersData;
 
+	/** Manager updating all AI sensing components */
+	UPROPERTY()
+	UStrategyAISensingManager* SensingManager;
+
+	/** Manager assigning targets to AI controllers */
+	UPROPERTY()
+	UStrategyAITargetingManager* TargetingManager;
+
+	/** Scheduler running AI decisions under per frame budget */
+	UPROPERTY()
+	UStrategyAIDecisionScheduler* DecisionScheduler;
+
+	/** Manager solving local avoidance of all minions */
+	UPROPERTY()
+	UStrategyAIAvoidanceManager* AvoidanceManager;
+
+	/** Pool of dead minions waiting for reuse */
+	UPROPERTY()
+	UStrategyMinionPool* MinionPool;
+
+	/** Spatial hash of all live characters, used for proximity queries */
+	FStrategyUnitGrid UnitGrid;
+
+	/** Registry of AI controllers claimed as targets by other controllers */
+	FStrategyAIClaimTable ClaimTable;
+
+	/** Cache of paths toward goal actors */
+	FStrategyPathCache PathCache;
+
+	/** Async loader of soft referenced classes, keeps what it loaded resident */
+	FStreamableManager StreamableManager;
+
+	/** navigation was rebuilt, build all flow fields again */
+	UFUNCTION()
+	void OnNavigationGenerated(ANavigationData* NavData);
+
+	/** async path query of PathCache finished, bound here so results arriving after we are gone are dropped */
+	void OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** continue building flow fields within per frame budget */
+	void UpdateFlowFieldBuilds();
+
+	/** make sure UpdateFlowFieldBuilds runs next frame */
+	void ScheduleFlowFieldBuilds();
+
+	/** set while UpdateFlowFieldBuilds is scheduled */
+	bool bFlowFieldBuildScheduled;
+
+	/** flow fields built so far, by goal */
+	TMap<TWeakObjectPtr<AActor>, TSharedPtr<FStrategyFlowField> > FlowFields;
+
+	/** incremented on every brewery change */
+	uint32 BreweryEpoch;
+
 	/** Count of live pawns for each team */
 	uint32 LivePawnCounter[EStrategyTeam::MAX];
 